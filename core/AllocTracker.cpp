@@ -0,0 +1,369 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "lib/AllocTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <format>
+#include <malloc.h>
+#include <new>
+#include <string>
+#include <thread>
+
+namespace {
+    constexpr size_t maxThreads = 256; // threads beyond that share slot 0
+    constexpr size_t siteCapacity = 4096;
+    constexpr size_t siteProbes = 64; // a site that is not found within that many entries is dropped
+
+    struct alignas(64) ThreadSlot {
+        std::atomic<uint64_t> allocations{0}, frees{0}, requestedBytes{0};
+        std::atomic<int64_t> liveBytes{0};
+        std::array<std::atomic<uint64_t>, X11App::allocSizeClasses> sizeClasses{};
+    };
+
+    /// Key of an entry whose frames are being stored. Keys of sites are odd, so they never collide with it.
+    constexpr uint64_t reservedKey = 2;
+
+    struct SiteEntry {
+        std::atomic<uint64_t> key{0}; // hash of the frames, 0 while the entry is free, reservedKey while it is filled
+        std::array<std::atomic<void *>, 3> frames{};
+        std::atomic<uint64_t> samples{0}, bytes{0};
+    };
+
+    // constant initialised, so they are ready for the allocations of static constructors
+    ThreadSlot s_Slots[maxThreads];
+    std::atomic<size_t> s_SlotsUsed{1};
+    SiteEntry s_Sites[siteCapacity];
+    std::atomic<uint64_t> s_SitesDropped{0};
+    std::atomic<uint32_t> s_SampleEvery{0};
+
+    thread_local ThreadSlot *t_Slot = nullptr;
+
+    ThreadSlot &slot() noexcept {
+        if (t_Slot == nullptr) {
+            const size_t index = s_SlotsUsed.fetch_add(1, std::memory_order_relaxed);
+            t_Slot = &s_Slots[index < maxThreads ? index : 0];
+        }
+        return *t_Slot;
+    }
+
+    /// @return The function, or module and offset, of a code address, for the report.
+    std::string frameName(void *address) {
+        Dl_info info{};
+        if (address == nullptr || dladdr(address, &info) == 0) return std::format("{}", address);
+        if (info.dli_sname != nullptr) {
+            int status = 0;
+            char *demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+            std::string name = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+            std::free(demangled);
+            return std::format("{}+{:#x}", name, reinterpret_cast<uintptr_t>(address) -
+                                                 reinterpret_cast<uintptr_t>(info.dli_saddr));
+        }
+        // the executable exports no symbols without -rdynamic: addr2line -fCe <module> <offset> resolves these
+        const std::string_view module = info.dli_fname != nullptr ? info.dli_fname : "?";
+        return std::format("{}+{:#x}", module.substr(module.rfind('/') + 1),
+                           reinterpret_cast<uintptr_t>(address) - reinterpret_cast<uintptr_t>(info.dli_fbase));
+    }
+
+    std::string sizeName(const size_t bytes) {
+        if (bytes < 1024) return std::format("{} B", bytes);
+        if (bytes < 1024 * 1024) return std::format("{} KiB", bytes / 1024);
+        return std::format("{} MiB", bytes / (1024 * 1024));
+    }
+}
+
+namespace X11App {
+    AllocStats allocStats() noexcept {
+        AllocStats stats;
+        const size_t used = std::min(s_SlotsUsed.load(std::memory_order_relaxed), maxThreads);
+        for (size_t i = 0; i < used; ++i) {
+            const ThreadSlot &counters = s_Slots[i];
+            stats.allocations += counters.allocations.load(std::memory_order_relaxed);
+            stats.frees += counters.frees.load(std::memory_order_relaxed);
+            stats.requestedBytes += counters.requestedBytes.load(std::memory_order_relaxed);
+            stats.liveBytes += counters.liveBytes.load(std::memory_order_relaxed);
+            for (size_t sizeClass = 0; sizeClass < allocSizeClasses; ++sizeClass)
+                stats.sizeClasses[sizeClass] += counters.sizeClasses[sizeClass].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+    uint64_t allocThreadCount() noexcept {
+        if constexpr (!allocTracking) return 0;
+        return slot().allocations.load(std::memory_order_relaxed);
+    }
+
+    void allocSampleEvery(const uint32_t n) noexcept {
+        if (n != 0) {
+            // the first backtrace loads the unwinder, get that out of the way before anything is sampled
+            void *warmup[1];
+            (void) backtrace(warmup, 1);
+        }
+        s_SampleEvery.store(n, std::memory_order_relaxed);
+    }
+
+    std::vector<AllocSite> allocSites() {
+        std::vector<AllocSite> sites;
+        for (const SiteEntry &entry: s_Sites) {
+            // the release store of the key comes after the frames, so they are complete once it is seen
+            const uint64_t key = entry.key.load(std::memory_order_acquire);
+            if (key == 0 || key == reservedKey) continue;
+            AllocSite &site = sites.emplace_back();
+            for (size_t i = 0; i < site.frames.size(); ++i)
+                site.frames[i] = entry.frames[i].load(std::memory_order_relaxed);
+            site.samples = entry.samples.load(std::memory_order_relaxed);
+            site.bytes = entry.bytes.load(std::memory_order_relaxed);
+        }
+        std::ranges::sort(sites, [](const AllocSite &a, const AllocSite &b) { return a.samples > b.samples; });
+        return sites;
+    }
+
+    void allocReport(std::ostream &out, const size_t topSites) {
+        // taken before the report allocates anything itself
+        const AllocStats stats = allocStats();
+        std::vector<AllocSite> sites = allocSites();
+
+        out << "=== Allocation statistics ===\n";
+        if constexpr (!allocTracking) {
+            out << "Not tracked, build with TRACK_ALLOCATIONS=1\n";
+            return;
+        }
+        out << std::format("Allocations: {}, requested {}, average {} B\n", stats.allocations,
+                           sizeName(stats.requestedBytes), stats.allocations > 0
+                                                               ? stats.requestedBytes / stats.allocations
+                                                               : 0);
+        // static objects are only destroyed after main returns, so a little is always still alive here
+        out << std::format("Frees: {}, still allocated: {} blocks, {}\n", stats.frees,
+                           static_cast<int64_t>(stats.allocations - stats.frees),
+                           sizeName(static_cast<size_t>(std::max<int64_t>(stats.liveBytes, 0))));
+
+        out << "Size classes:\n";
+        for (size_t sizeClass = 0; sizeClass < allocSizeClasses; ++sizeClass) {
+            const uint64_t count = stats.sizeClasses[sizeClass];
+            if (count == 0) continue;
+            const std::string bound = sizeClass + 1 < allocSizeClasses
+                                          ? "<= " + sizeName(size_t{16} << sizeClass)
+                                          : "> " + sizeName(size_t{16} << (sizeClass - 1));
+            out << std::format("  {:<10} {:>12} {:>6.1f}%\n", bound, count,
+                               100.0 * static_cast<double>(count) / static_cast<double>(stats.allocations));
+        }
+
+        const uint32_t every = s_SampleEvery.load(std::memory_order_relaxed);
+        if (every != 0 && !sites.empty()) {
+            out << std::format("Top call sites, 1 in {} allocations sampled:\n", every);
+            sites.resize(std::min(sites.size(), topSites));
+            for (const AllocSite &site: sites) {
+                out << std::format("  {} samples, {}\n", site.samples, sizeName(site.bytes));
+                for (void *frame: site.frames) if (frame != nullptr) out << "      " << frameName(frame) << '\n';
+            }
+            if (const uint64_t dropped = s_SitesDropped.load(std::memory_order_relaxed); dropped > 0)
+                out << dropped << " samples dropped, the site table is full\n";
+        }
+        out << "=============================" << std::endl;
+    }
+}
+
+#if TRACK_ALLOCATIONS
+namespace {
+    thread_local uint32_t t_SampleCountdown = 0;
+    thread_local bool t_Sampling = false; // backtrace may allocate itself
+
+    [[gnu::noinline]] void sample(const size_t size) noexcept {
+        // frames 0 to 2 are sample, track and operator new
+        void *stack[6]{};
+        const int depth = backtrace(stack, 6);
+        std::array<void *, 3> frames{};
+        uint64_t key = 0xcbf29ce484222325;
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (static_cast<int>(i + 3) < depth) frames[i] = stack[i + 3];
+            key = (key ^ reinterpret_cast<uintptr_t>(frames[i])) * 0x100000001b3;
+        }
+        key |= 1;
+
+        for (size_t probe = 0; probe < siteProbes; ++probe) {
+            SiteEntry &entry = s_Sites[(key + probe) % siteCapacity];
+            uint64_t found = entry.key.load(std::memory_order_acquire);
+            if (found == 0 && entry.key.compare_exchange_strong(found, reservedKey, std::memory_order_acquire)) {
+                // publish the key only once the frames are in, readers and other writers match on it
+                for (size_t i = 0; i < frames.size(); ++i) entry.frames[i].store(frames[i], std::memory_order_relaxed);
+                entry.key.store(key, std::memory_order_release);
+                found = key;
+            }
+            // another thread is storing the frames of this entry, which may be of the same site
+            while (found == reservedKey) {
+                std::this_thread::yield();
+                found = entry.key.load(std::memory_order_acquire);
+            }
+            if (found != key) continue;
+            entry.samples.fetch_add(1, std::memory_order_relaxed);
+            entry.bytes.fetch_add(size, std::memory_order_relaxed);
+            return;
+        }
+        s_SitesDropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[gnu::noinline]] void track(void *ptr, const size_t size) noexcept {
+        ThreadSlot &counters = slot();
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        counters.requestedBytes.fetch_add(size, std::memory_order_relaxed);
+        counters.liveBytes.fetch_add(static_cast<int64_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+        counters.sizeClasses[X11App::allocSizeClass(size)].fetch_add(1, std::memory_order_relaxed);
+
+        const uint32_t every = s_SampleEvery.load(std::memory_order_relaxed);
+        if (every == 0 || t_Sampling || ++t_SampleCountdown < every) return;
+        t_SampleCountdown = 0;
+        t_Sampling = true;
+        sample(size);
+        t_Sampling = false;
+    }
+
+    void untrack(void *ptr) noexcept {
+        if (ptr == nullptr) return;
+        ThreadSlot &counters = slot();
+        counters.frees.fetch_add(1, std::memory_order_relaxed);
+        counters.liveBytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+    }
+
+    /// Allocate like the standard operator new: retry through the new handler, throw if there is none.
+    void *allocate(const size_t size, const size_t alignment = 0) {
+        while (true) {
+            void *ptr = nullptr;
+            if (alignment == 0) ptr = std::malloc(size != 0 ? size : 1);
+            else if (posix_memalign(&ptr, std::max(alignment, sizeof(void *)), size != 0 ? size : 1) != 0)
+                ptr = nullptr;
+            if (ptr != nullptr) return ptr;
+
+            const std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) throw std::bad_alloc();
+            handler();
+        }
+    }
+
+    void *allocateNothrow(const size_t size, const size_t alignment = 0) noexcept {
+        try {
+            return allocate(size, alignment);
+        } catch (...) {
+            return nullptr;
+        }
+    }
+}
+
+// every replaceable form, so no allocation escapes the counters; the array forms call track themselves to keep
+// the number of frames above a sampled call site the same
+
+void *operator new(const size_t size) {
+    void *ptr = allocate(size);
+    track(ptr, size);
+    return ptr;
+}
+
+void *operator new[](const size_t size) {
+    void *ptr = allocate(size);
+    track(ptr, size);
+    return ptr;
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment) {
+    void *ptr = allocate(size, static_cast<size_t>(alignment));
+    track(ptr, size);
+    return ptr;
+}
+
+void *operator new[](const size_t size, const std::align_val_t alignment) {
+    void *ptr = allocate(size, static_cast<size_t>(alignment));
+    track(ptr, size);
+    return ptr;
+}
+
+void *operator new(const size_t size, const std::nothrow_t &) noexcept {
+    void *ptr = allocateNothrow(size);
+    if (ptr != nullptr) track(ptr, size);
+    return ptr;
+}
+
+void *operator new[](const size_t size, const std::nothrow_t &) noexcept {
+    void *ptr = allocateNothrow(size);
+    if (ptr != nullptr) track(ptr, size);
+    return ptr;
+}
+
+void *operator new(const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    void *ptr = allocateNothrow(size, static_cast<size_t>(alignment));
+    if (ptr != nullptr) track(ptr, size);
+    return ptr;
+}
+
+void *operator new[](const size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    void *ptr = allocateNothrow(size, static_cast<size_t>(alignment));
+    if (ptr != nullptr) track(ptr, size);
+    return ptr;
+}
+
+// the sizes passed to the sized forms are ignored, malloc_usable_size covers the unsized ones as well
+
+void operator delete(void *ptr) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    untrack(ptr);
+    std::free(ptr);
+}
+#endif
@@ -4,11 +4,20 @@
 
 #include "App.h"
 
+#include <X11/extensions/Xdbe.h>
+
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <iostream>
 #include <climits>
+#include <cstdio>
+#include <poll.h>
 #include <ranges>
 #include <stdexcept>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
 #define QUIT_EARLY_WITH_DEBUG_TRAP(ASSERTION, MSG, ...)  if (ASSERTION) return debug_trap(MSG, __VA_ARGS__); // silently ignore
 
@@ -16,6 +25,19 @@
 
 #define REQUIRE_WINDOW(WIN_ID, MSG)  if (!windowCheckOpen(WIN_ID)) throw std::runtime_error(MSG);
 
+namespace {
+    /// Call send for consecutive slices of items holding at most maxBytes worth of elements each.
+    template<typename T, typename SendFunc>
+    void sendChunked(const std::vector<T> &items, const size_t maxBytes, SendFunc &&send) {
+        const size_t maxItems = std::max<size_t>(1, maxBytes / sizeof(T));
+        for (size_t offset = 0; offset < items.size(); offset += maxItems) {
+            const size_t count = std::min(maxItems, items.size() - offset);
+            // Xlib takes non const pointers but never writes through them
+            send(const_cast<T *>(items.data() + offset), static_cast<int>(count));
+        }
+    }
+}
+
 // https://www.mankier.com/
 namespace X11App {
     // |*********************************************|
@@ -55,6 +77,11 @@ namespace X11App {
     void App::windowClose(const int winId) noexcept {
         QUIT_EARLY_WITH_DEBUG_TRAP(!windowCheckOpen(winId), "Trying to force close a non-existent window ID %d", winId)
 
+        imageRelease(winId);
+        if (windowIsDoubleBuffered(winId)) backBufferFree(winId);
+        layerRemove(winId);
+        m_GCCache.invalidate(winId);
+        m_Damage.erase(winId);
         XDestroyWindow(m_Display, m_Windows[winId]);
         m_Windows.erase(winId);
     }
@@ -66,7 +93,13 @@ namespace X11App {
     void App::windowClear(const int winId, const bool flush) const noexcept {
         QUIT_EARLY_WITH_DEBUG_TRAP(!windowCheckOpen(winId), "Trying to force clear a non-existent window ID %d", winId)
 
-        XClearWindow(m_Display, m_Windows.at(winId));
+        if (const auto it = m_BackBuffers.find(winId); it != m_BackBuffers.end()) {
+            // back buffers have no background, paint the layer or the window background color instead
+            layerClear(winId, it->second.drawable, {
+                           0, 0, static_cast<unsigned short>(it->second.width),
+                           static_cast<unsigned short>(it->second.height)
+                       });
+        } else layerClear(winId, m_Windows.at(winId), DamageRegion::everything);
         if (flush) XFlush(m_Display);
     }
 
@@ -76,12 +109,13 @@ namespace X11App {
 
         const Window activeWindow = m_Windows.at(winId);
 
-        auto emptyEvent = XExposeEvent{
+        constexpr XRectangle area = DamageRegion::everything;
+        auto fullEvent = XExposeEvent{
             .type = Expose, .serial = 0, .send_event = False, .display = m_Display,
-            .window = activeWindow, .x = 0, .y = 0, .width = 0, .height = 0, .count = 0
+            .window = activeWindow, .x = area.x, .y = area.y, .width = area.width, .height = area.height, .count = 0
         };
 
-        handleExpose(emptyEvent);
+        handleExpose(fullEvent);
     }
 
     bool App::windowCheckOpen(const int winId) const noexcept {
@@ -105,13 +139,73 @@ namespace X11App {
     }
 
     void App::windowProcessRedrawQueue() noexcept {
-        while (!m_RedrawQueue.empty()) {
-            if (const auto winId = m_RedrawQueue.front(); windowCheckOpen(winId)) {
-                windowClear(winId, true);
-                windowForceRedraw(winId);
+        PROFILE_ZONE("redraw");
+        bool drawn = false;
+        for (auto &[winId, damage]: m_Damage) {
+            if (damage.empty()) continue;
+            if (!windowCheckOpen(winId)) {
+                damage.clear();
+                continue;
             }
-            m_RedrawQueue.pop();
-        };
+
+            if (const auto layer = m_Layers.find(winId); layer != m_Layers.end() && layer->second.stale)
+                layerRender(winId);
+
+            // handleExpose may damage the window again, so work on a copy
+            m_DamageScratch.assign(damage.rects().begin(), damage.rects().end());
+            damage.clear();
+
+            const int count = static_cast<int>(m_DamageScratch.size());
+            for (int i = 0; i < count; ++i) windowRedrawArea(winId, m_DamageScratch[i], count - 1 - i);
+            backBufferPresent(winId, m_DamageScratch);
+            drawn = true;
+        }
+        if (drawn) XFlush(m_Display);
+    }
+
+    void App::windowSetDoubleBuffered(const int winId, const bool enabled, const bool preferDbe) {
+        REQUIRE_WINDOW(winId, "Attempting to change double buffering of a non-existent window ID " + std::to_string(winId))
+
+        if (!enabled) {
+            if (windowIsDoubleBuffered(winId)) backBufferFree(winId);
+            return;
+        }
+        if (windowIsDoubleBuffered(winId)) return;
+
+        const Window window = m_Windows.at(winId);
+        const auto attrs = windowGetAttributes(winId);
+        BackBuffer buffer{};
+
+        int major, minor;
+        if (preferDbe && XdbeQueryExtension(m_Display, &major, &minor)) {
+            // DBE only works on visuals the server lists as double buffer capable
+            int numScreens = 1;
+            Drawable root = RootWindow(m_Display, m_ScreenId);
+            if (XdbeScreenVisualInfo *info = XdbeGetVisualInfo(m_Display, &root, &numScreens)) {
+                const VisualID visualId = XVisualIDFromVisual(attrs.visual);
+                for (int i = 0; i < info->count && !buffer.isDbe; ++i) buffer.isDbe = info->visinfo[i].visual == visualId;
+                XdbeFreeVisualInfo(info);
+            }
+            if (buffer.isDbe) buffer.drawable = XdbeAllocateBackBufferName(m_Display, window, XdbeCopied);
+        }
+
+        // only track resizes ourselves if the application did not ask for them
+        if (!(attrs.your_event_mask & StructureNotifyMask)) {
+            XSelectInput(m_Display, window, attrs.your_event_mask | StructureNotifyMask);
+            buffer.ownsStructureMask = true;
+        }
+
+        // the server must not clear exposed areas anymore, they are repaired from the back buffer
+        XSetWindowBackgroundPixmap(m_Display, window, None);
+        if (const auto layer = m_Layers.find(winId); layer != m_Layers.end()) layer->second.installed = false;
+
+        m_BackBuffers[winId] = buffer;
+        backBufferResize(winId, attrs.width, attrs.height);
+        windowScheduleRedraw(winId);
+    }
+
+    void App::windowPresent(const int winId) const noexcept {
+        backBufferPresent(winId, {&DamageRegion::everything, 1});
     }
 
     //|*********************************************|
@@ -134,26 +228,20 @@ namespace X11App {
                             const PixelPos height) const {
         REQUIRE_WINDOW(winId, "Attempting to draw a rectangle on a non-existent window ID " + std::to_string(winId))
 
-        const Window activeWindow = m_Windows.at(winId);
+        const Drawable target = windowDrawable(winId);
 
-        const GC gc = XCreateGC(m_Display, activeWindow, 0, nullptr);
-        XSetForeground(m_Display, gc, color.pixel);
-        XFillRectangle(m_Display, activeWindow, gc, x, y, width, height);
-
-        XFreeGC(m_Display, gc);
+        const GC gc = gcGet(winId, {.foreground = color.pixel});
+        XFillRectangle(m_Display, target, gc, x, y, width, height);
     }
 
     void App::drawCircle(const int winId, const XColor &color, const PixelPos x, const PixelPos y,
                          const PixelPos radius) const {
         REQUIRE_WINDOW(winId, "Attempting to draw a circle on a non-existent window ID " + std::to_string(winId))
 
-        const Window activeWindow = m_Windows.at(winId);
-
-        const GC gc = XCreateGC(m_Display, activeWindow, 0, nullptr);
-        XSetForeground(m_Display, gc, color.pixel);
-        XFillArc(m_Display, activeWindow, gc, x - radius, y - radius, radius * 2, radius * 2, 0, 360 * 64);
+        const Drawable target = windowDrawable(winId);
 
-        XFreeGC(m_Display, gc);
+        const GC gc = gcGet(winId, {.foreground = color.pixel});
+        XFillArc(m_Display, target, gc, x - radius, y - radius, radius * 2, radius * 2, 0, 360 * 64);
     }
 
     void App::drawText(const int winId, const XColor &color, const PixelPos x, const PixelPos y, const str fontStr,
@@ -161,54 +249,342 @@ namespace X11App {
         REQUIRE_WINDOW(winId, "Attempting to draw text on a non-existent window ID " + std::to_string(winId))
 
         if (text.empty() || text.size() >= INT_MAX) return;
-        const Window activeWindow = m_Windows.at(winId);
-
-        const GC gc = XCreateGC(m_Display, activeWindow, 0, nullptr);
-
-        const Font fontObj = XLoadFont(m_Display, fontStr.data());
-        XSetFont(m_Display, gc, fontObj);
-
-        XSetForeground(m_Display, gc, color.pixel);
-        XDrawString(m_Display, activeWindow, gc, x, y, text.data(), static_cast<int>(text.size()));
+        const Drawable target = windowDrawable(winId);
 
-        XUnloadFont(m_Display, fontObj);
-        XFreeGC(m_Display, gc);
+        const XFontStruct &font = m_FontCache.get(fontStr);
+        const GC gc = gcGet(winId, {.foreground = color.pixel, .font = font.fid});
+        XDrawString(m_Display, target, gc, x, y, text.data(), static_cast<int>(text.size()));
     }
 
     void App::drawPolygon(const int winId, const XColor &color, std::vector<XPoint> &points) const {
         REQUIRE_WINDOW(winId, "Attempting to draw a polygon on a non-existent window ID " + std::to_string(winId))
 
-        const Window activeWindow = m_Windows.at(winId);
+        const Drawable target = windowDrawable(winId);
         if (points.size() < 3 || points.size() > INT_MAX)
             throw std::runtime_error(
                 "A polygon must have at least 3 points");
 
-        const GC gc = XCreateGC(m_Display, activeWindow, 0, nullptr);
-        XSetForeground(m_Display, gc, color.pixel);
-        XFillPolygon(m_Display, activeWindow, gc, points.data(), static_cast<int>(points.size()), Convex,
+        const GC gc = gcGet(winId, {.foreground = color.pixel});
+        XFillPolygon(m_Display, target, gc, points.data(), static_cast<int>(points.size()), Convex,
                      CoordModeOrigin);
-
-        XFreeGC(m_Display, gc);
     }
 
     void App::drawLine(const int winId, const XColor &color, const PixelPos x1, const PixelPos y1, const PixelPos x2, const PixelPos y2) const {
         REQUIRE_WINDOW(winId, "Attempting to draw a line on a non-existent window ID " + std::to_string(winId))
-        const Window activeWindow = m_Windows.at(winId);
+        const Drawable target = windowDrawable(winId);
+
+        const GC gc = gcGet(winId, {.foreground = color.pixel});
+        XDrawLine(m_Display, target, gc, x1, y1, x2, y2);
+    }
+
+    DrawBatch &App::batchBegin(const int winId) {
+        REQUIRE_WINDOW(winId, "Attempting to begin a batch on a non-existent window ID " + std::to_string(winId))
+
+        m_Batch.begin(winId);
+        return m_Batch;
+    }
+
+    void App::batchSubmit() {
+        if (!m_Batch.active()) return;
+        const int winId = m_Batch.winId();
+        if (!windowCheckOpen(winId)) {
+            m_Batch.clear();
+            return;
+        }
+
+        const Drawable target = windowDrawable(winId);
+        // request length is counted in 4 byte units, the poly requests have a 12 byte header
+        const size_t maxPayload = static_cast<size_t>(XMaxRequestSize(m_Display)) * 4 - 12;
+
+        for (const auto &[pixel, bucket]: m_Batch.buckets()) {
+            if (bucket.empty()) continue;
+            const GC gc = gcGet(winId, {.foreground = pixel});
+
+            sendChunked(bucket.rectangles, maxPayload, [&](XRectangle *data, const int count) {
+                XFillRectangles(m_Display, target, gc, data, count);
+            });
+            sendChunked(bucket.segments, maxPayload, [&](XSegment *data, const int count) {
+                XDrawSegments(m_Display, target, gc, data, count);
+            });
+            sendChunked(bucket.arcs, maxPayload, [&](XArc *data, const int count) {
+                XFillArcs(m_Display, target, gc, data, count);
+            });
+            sendChunked(bucket.points, maxPayload, [&](XPoint *data, const int count) {
+                XDrawPoints(m_Display, target, gc, data, count, CoordModeOrigin);
+            });
+        }
+
+        m_Batch.clear();
+    }
+
+
+    // |*********************************************|
+    // |                    Image                    |
+    // |*********************************************|
+
+    ImageView App::imageAcquire(const int winId, const u16 width, const u16 height) {
+        REQUIRE_WINDOW(winId, "Attempting to acquire an image of a non-existent window ID " + std::to_string(winId))
+
+        auto &image = m_Images[winId];
+        if (image && image->width() == width && image->height() == height) {
+            imageWaitCompletion(winId);
+            return image->view();
+        }
+
+        image.reset();
+        const auto attrs = windowGetAttributes(winId);
+        try {
+            image = std::make_unique<ShmImage>(m_Display, attrs.visual, attrs.depth, width, height,
+                                               m_ShmCompletionType != -1);
+        } catch (...) {
+            m_Images.erase(winId);
+            throw;
+        }
+        return image->view();
+    }
+
+    void App::imagePresent(const int winId, const PixelPos x, const PixelPos y) {
+        REQUIRE_WINDOW(winId, "Attempting to present an image of a non-existent window ID " + std::to_string(winId))
+        const auto it = m_Images.find(winId);
+        if (it == m_Images.end()) throw std::runtime_error("Window ID " + std::to_string(winId) + " has no image");
+
+        it->second->put(windowDrawable(winId), gcGet(winId, {}), x, y);
+        XFlush(m_Display);
+    }
+
+    void App::imageRelease(const int winId) noexcept {
+        if (!m_Images.contains(winId)) return;
+        // the server may still be reading from the segment
+        imageWaitCompletion(winId);
+        m_Images.erase(winId);
+    }
+
+    uint32_t App::imagePack(const int winId, const uint8_t red, const uint8_t green, const uint8_t blue) const {
+        const auto it = m_Images.find(winId);
+        if (it == m_Images.end()) throw std::runtime_error("Window ID " + std::to_string(winId) + " has no image");
+        return it->second->pack(red, green, blue);
+    }
+
+    // |*********************************************|
+    // |                 Frame Loop                  |
+    // |*********************************************|
+
+    void App::frameLoopRun(const FrameLoopConfig &config) {
+        using Clock = std::chrono::steady_clock;
+        using Ms = std::chrono::duration<double, std::milli>;
+
+        const int timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (timerFd < 0) throw std::runtime_error("Failed to create frame timer");
+
+        const auto stepInterval = std::chrono::milliseconds(config.fixedStepMs);
+        const auto frameInterval = config.targetFps > 0
+                                       ? std::chrono::duration_cast<Clock::duration>(
+                                           std::chrono::duration<double>(1.0 / config.targetFps))
+                                       : Clock::duration::zero();
+
+        PROFILE_THREAD("frame loop");
+        auto lastTime = Clock::now();
+        auto lastFrame = lastTime - frameInterval;
+        Clock::duration accumulator{};
+
+        m_FrameLoopRunning = true;
+        while (m_FrameLoopRunning) {
+            const auto workStart = Clock::now();
+            const uint64_t allocationsBefore = allocThreadCount();
+            m_FrameStats.wakeups++;
+            handleAllQueuedEvents();
+            m_KeyStateManager.frameAdvance();
+
+            // fixed timestep with accumulator, so the simulation rate does not drift with the work time
+            const auto now = Clock::now();
+            const bool stepping = config.fixedStepMs > 0 && m_FixedStepEnabled;
+            if (stepping) {
+                accumulator += now - lastTime;
+                int steps = 0;
+                for (; accumulator >= stepInterval && steps < config.maxStepsPerIteration; ++steps) {
+                    PROFILE_ZONE("fixedStep");
+                    frameFixedStep();
+                    accumulator -= stepInterval;
+                }
+                m_FrameStats.fixedSteps += steps;
+                if (accumulator >= stepInterval) {
+                    m_FrameStats.droppedSteps += accumulator / stepInterval;
+                    accumulator %= stepInterval;
+                }
+            } else accumulator = Clock::duration::zero();
+            lastTime = now;
+
+            {
+                PROFILE_ZONE("frameUpdate");
+                frameUpdate();
+            }
+            if (!m_FrameLoopRunning) break;
+
+            if (!config.renderOnlyWhenDirty)
+                for (const int winId: m_Windows | std::views::keys) windowScheduleRedraw(winId);
+
+            const bool frameDue = Clock::now() - lastFrame >= frameInterval;
+            if (frameDue && windowAnyDamaged()) {
+                windowProcessRedrawQueue();
+                const auto frameEnd = Clock::now();
+                m_FrameStats.recordFrame(Ms(frameEnd - workStart).count(), Ms(frameEnd - lastFrame).count());
+                lastFrame = frameEnd;
+            }
+
+            // sleep until the next step or frame is due, or an event arrives
+            Clock::time_point deadline = Clock::time_point::max();
+            if (stepping) deadline = lastTime + (stepInterval - accumulator);
+            if (windowAnyDamaged()) deadline = std::min(deadline, lastFrame + frameInterval);
+
+            // steady_clock is CLOCK_MONOTONIC, so its time points can be used as absolute timer values
+            itimerspec timer{};
+            if (deadline != Clock::time_point::max()) {
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).
+                        count();
+                // 0 would disarm the timer, a deadline in the past fires immediately
+                timer.it_value.tv_sec = std::max<long long>(ns, 1) / 1'000'000'000;
+                timer.it_value.tv_nsec = std::max<long long>(ns, 1) % 1'000'000'000;
+            }
+            timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &timer, nullptr);
+
+            {
+                PROFILE_ZONE("flush");
+                XFlush(m_Display);
+            }
+            // everything up to here was the work of this iteration, the rest is waiting
+            const uint64_t allocations = allocThreadCount() - allocationsBefore;
+            if (m_FrameStats.recordAllocations(allocations, config.allocationBudget))
+                fprintf(stderr, "Frame loop iteration %llu allocated %llu times, the budget is %d\n",
+                        static_cast<unsigned long long>(m_FrameStats.wakeups),
+                        static_cast<unsigned long long>(allocations), config.allocationBudget);
+            PROFILE_FRAME();
+
+            // with the input thread running, events arrive through its eventfd instead of the connection
+            const bool threaded = inputThreaded();
+            pollfd fds[3] = {
+                {.fd = threaded ? m_InputEventFd : ConnectionNumber(m_Display), .events = POLLIN, .revents = 0},
+                {.fd = timerFd, .events = POLLIN, .revents = 0},
+                {.fd = m_FrameWakeFd, .events = POLLIN, .revents = 0}
+            };
+            // events that were already read would not wake poll
+            const bool eventsWaiting = threaded
+                                           ? !m_InputQueue->empty() || !m_DeferredEvents.empty()
+                                           : XEventsQueued(m_Display, QueuedAlready) != 0;
+            if (!eventsWaiting) poll(fds, 3, -1);
+
+            uint64_t counter;
+            if (fds[1].revents & POLLIN) (void) read(timerFd, &counter, sizeof(counter));
+            if (fds[2].revents & POLLIN) (void) read(m_FrameWakeFd, &counter, sizeof(counter));
+            if (threaded && fds[0].revents & POLLIN) (void) read(m_InputEventFd, &counter, sizeof(counter));
+        }
+
+        close(timerFd);
+    }
+
+    void App::frameWake() const noexcept {
+        constexpr uint64_t one = 1;
+        (void) write(m_FrameWakeFd, &one, sizeof(one));
+    }
+
+    // |*********************************************|
+    // |                 Input Thread                |
+    // |*********************************************|
+
+    void App::inputThreadStart() {
+        if (inputThreaded()) return;
+        if (!s_ThreadsInitialised)
+            throw std::runtime_error("The input thread requires the App to be created with initThreads = true");
+
+        m_InputEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_InputEventFd < 0) throw std::runtime_error("Failed to create input event fd");
+        if (!m_InputQueue) m_InputQueue = std::make_unique<InputQueue>();
 
-        const GC gc = XCreateGC(m_Display, activeWindow, 0, nullptr);
+        // never mapped, only used to send ourselves a ClientMessage that unblocks XNextEvent
+        XSetWindowAttributes attrs{};
+        m_InputWakeWindow = XCreateWindow(m_Display, RootWindow(m_Display, m_ScreenId), 0, 0, 1, 1, 0, 0, InputOnly,
+                                          CopyFromParent, 0, &attrs);
+        XFlush(m_Display);
 
-        XSetForeground(m_Display, gc, color.pixel);
-        XDrawLine(m_Display, activeWindow, gc, x1, y1, x2, y2);
+        m_InputThreadStop.store(false, std::memory_order_relaxed);
+        m_InputThread = std::thread(&App::inputThreadLoop, this);
+    }
 
-        XFreeGC(m_Display, gc);
+    void App::inputThreadStop() noexcept {
+        if (!inputThreaded()) return;
+
+        m_InputThreadStop.store(true, std::memory_order_release);
+        XEvent wake{};
+        wake.xclient.type = ClientMessage;
+        wake.xclient.window = m_InputWakeWindow;
+        wake.xclient.format = 32;
+        XSendEvent(m_Display, m_InputWakeWindow, False, NoEventMask, &wake);
+        XFlush(m_Display);
+        m_InputThread.join();
+
+        XDestroyWindow(m_Display, m_InputWakeWindow);
+        m_InputWakeWindow = None;
+        close(m_InputEventFd);
+        m_InputEventFd = -1;
     }
 
+    void App::inputThreadLoop() {
+        PROFILE_THREAD("input");
+        QueuedEvent queued{};
+        while (!m_InputThreadStop.load(std::memory_order_acquire)) {
+            XNextEvent(m_Display, &queued.event);
+            if (queued.event.type == ClientMessage && queued.event.xclient.window == m_InputWakeWindow) continue;
+
+            queued.received = std::chrono::steady_clock::now();
+            // back pressure instead of dropping input, the main loop is expected to catch up quickly
+            while (!m_InputQueue->tryPush(queued)) {
+                m_InputFullStalls.fetch_add(1, std::memory_order_relaxed);
+                if (m_InputThreadStop.load(std::memory_order_acquire)) return;
+                std::this_thread::yield();
+            }
+
+            constexpr uint64_t one = 1;
+            (void) write(m_InputEventFd, &one, sizeof(one));
+        }
+    }
+
+    bool App::inputQueuePop(QueuedEvent &out) noexcept {
+        if (!m_DeferredEvents.empty()) {
+            out = m_DeferredEvents.front();
+            m_DeferredEvents.erase(m_DeferredEvents.begin());
+            return true;
+        }
+        return m_InputQueue && m_InputQueue->tryPop(out);
+    }
+
+    void App::inputQueueWait(const int timeoutMs) const noexcept {
+        pollfd fd{.fd = m_InputEventFd, .events = POLLIN, .revents = 0};
+        if (poll(&fd, 1, timeoutMs) > 0) {
+            uint64_t counter;
+            (void) read(m_InputEventFd, &counter, sizeof(counter));
+        }
+    }
 
     // |*********************************************|
     // |               Event Handling                |
     // |*********************************************|
 
     void App::handleAllQueuedEvents() {
+        PROFILE_ZONE("events");
+        // events read by the input thread, also drained after it stopped
+        if (m_InputQueue || !m_DeferredEvents.empty()) {
+            // only handle what is queued right now, so a flood of events cannot starve the rest of the frame
+            const size_t batch = m_DeferredEvents.size() + (m_InputQueue ? m_InputQueue->size() : 0);
+            if (batch > 0) m_InputStats.recordBatch(batch);
+
+            QueuedEvent queued;
+            for (size_t i = 0; i < batch && inputQueuePop(queued); ++i) {
+                const std::chrono::duration<double, std::micro> age = std::chrono::steady_clock::now() - queued.received;
+                m_InputStats.recordEvent(age.count());
+                handleEvent(queued.event);
+            }
+            if (inputThreaded()) return;
+        }
+
         XEvent event;
         while (XPending(m_Display)) {
             XNextEvent(m_Display, &event);
@@ -217,6 +593,8 @@ namespace X11App {
     }
 
     void App::handleEvent(XEvent &event) {
+        if (handleInternalEvent(event)) return;
+
         switch (event.type) {
             case Expose: handleExpose(event.xexpose);
                 break;
@@ -273,14 +651,81 @@ namespace X11App {
         }
     }
 
+    bool App::handleInternalEvent(XEvent &event) {
+        if (event.type == m_ShmCompletionType) {
+            const auto &completion = reinterpret_cast<const XShmCompletionEvent &>(event);
+            for (const auto &image: m_Images | std::views::values)
+                if (image->segment() == completion.shmseg) image->complete();
+            return true;
+        }
+
+        const auto winId = windowRawToId(event.xany.window);
+        if (!winId.has_value()) return false;
+
+        bool layerOwnsStructureMask = false;
+        if (const auto layer = m_Layers.find(winId.value()); layer != m_Layers.end()) {
+            layerOwnsStructureMask = layer->second.ownsStructureMask;
+            // moves and restacking keep the layer, only a new size needs it rendered again
+            if (event.type == ConfigureNotify &&
+                (static_cast<unsigned int>(event.xconfigure.width) != layer->second.width ||
+                 static_cast<unsigned int>(event.xconfigure.height) != layer->second.height)) {
+                layer->second.stale = true;
+                windowScheduleRedraw(winId.value());
+            }
+        }
+        const bool structureEvent = event.type == ConfigureNotify || event.type == MapNotify ||
+                                    event.type == UnmapNotify || event.type == ReparentNotify ||
+                                    event.type == GravityNotify || event.type == CirculateNotify;
+
+        const auto it = m_BackBuffers.find(winId.value());
+        if (it == m_BackBuffers.end()) {
+            if (structureEvent) return layerOwnsStructureMask;
+            if (event.type != Expose) return false;
+            // merge into the damage region, so overlapping exposures and scheduled redraws are drawn only once
+            const XExposeEvent &expose = event.xexpose;
+            windowScheduleRedraw(winId.value(), {
+                                     static_cast<short>(expose.x), static_cast<short>(expose.y),
+                                     static_cast<unsigned short>(expose.width),
+                                     static_cast<unsigned short>(expose.height)
+                                 });
+            return true;
+        }
+
+        switch (event.type) {
+            case Expose: {
+                // repair the damaged area from the back buffer, no need to render the frame again
+                const XExposeEvent &expose = event.xexpose;
+                const XRectangle area{
+                    static_cast<short>(expose.x), static_cast<short>(expose.y),
+                    static_cast<unsigned short>(expose.width), static_cast<unsigned short>(expose.height)
+                };
+                backBufferPresent(winId.value(), {&area, 1});
+                return true;
+            }
+            case ConfigureNotify:
+                backBufferResize(winId.value(), event.xconfigure.width, event.xconfigure.height);
+                return it->second.ownsStructureMask || layerOwnsStructureMask;
+            case MapNotify:
+            case UnmapNotify:
+            case ReparentNotify:
+            case GravityNotify:
+            case CirculateNotify:
+                return it->second.ownsStructureMask || layerOwnsStructureMask;
+            default: return false;
+        }
+    }
+
     void App::handleKeyPress(XKeyEvent &event) {
-        const KeySym sym = XLookupKeysym(&event, 0);
-        m_KeyStateManager.setKeyPressed(sym);
+        m_KeyStateManager.setKeyPressed(event.keycode);
     }
 
     void App::handleKeyRelease(XKeyEvent &event) {
-        const KeySym sym = XLookupKeysym(&event, 0);
-        m_KeyStateManager.setKeyReleased(sym);
+        m_KeyStateManager.setKeyReleased(event.keycode);
+    }
+
+    void App::handleMappingNotify(XMappingEvent &event) {
+        XRefreshKeyboardMapping(&event);
+        if (event.request == MappingKeyboard) m_KeyStateManager.mappingLoad(m_Display);
     }
 
     void App::handleClientMessage(XClientMessageEvent &event) {
@@ -324,11 +769,230 @@ namespace X11App {
         return XLookupKeysym(const_cast<XKeyEvent *>(&event), 0) == XK_Key;
     }
 
+    // |*********************************************|
+    // |               Helper Functions              |
+    // |*********************************************|
+
+    Drawable App::windowDrawable(const int winId) const {
+        if (m_LayerTarget != None && winId == m_LayerWinId) return m_LayerTarget;
+        if (const auto it = m_BackBuffers.find(winId); it != m_BackBuffers.end()) return it->second.drawable;
+        return m_Windows.at(winId);
+    }
+
+    void App::imageWaitCompletion(const int winId) {
+        const auto it = m_Images.find(winId);
+        if (it == m_Images.end() || !it->second->pending()) return;
+
+        // the input thread may already have read the completion event, everything else is kept for later
+        if (m_InputQueue) {
+            std::vector<QueuedEvent> skipped;
+            QueuedEvent queued;
+            while (it->second->pending()) {
+                if (m_InputQueue->tryPop(queued)) {
+                    if (queued.event.type == m_ShmCompletionType) handleInternalEvent(queued.event);
+                    else skipped.push_back(queued);
+                } else if (inputThreaded()) inputQueueWait(-1);
+                else break;
+            }
+            m_DeferredEvents.insert(m_DeferredEvents.end(), skipped.begin(), skipped.end());
+            if (!it->second->pending()) return;
+        }
+
+        struct Match {
+            int type;
+            ShmSeg segment;
+        } match{m_ShmCompletionType, it->second->segment()};
+
+        // only take the completion event out of the queue, everything else stays for handleAllQueuedEvents
+        XEvent event;
+        XIfEvent(m_Display, &event, [](Display *, XEvent *e, const XPointer arg) -> Bool {
+            const auto *m = reinterpret_cast<const Match *>(arg);
+            return e->type == m->type && reinterpret_cast<const XShmCompletionEvent *>(e)->shmseg == m->segment;
+        }, reinterpret_cast<XPointer>(&match));
+        it->second->complete();
+    }
+
+    bool App::windowAnyDamaged() const noexcept {
+        return std::ranges::any_of(m_Damage | std::views::values, [](const DamageRegion &d) { return !d.empty(); });
+    }
+
+    void App::windowRedrawArea(const int winId, const XRectangle &area, const int count) noexcept {
+        m_GCCache.setClip(area);
+        layerClear(winId, windowDrawable(winId), area);
+
+        auto event = XExposeEvent{
+            .type = Expose, .serial = 0, .send_event = False, .display = m_Display,
+            .window = m_Windows.at(winId), .x = area.x, .y = area.y, .width = area.width, .height = area.height,
+            .count = count
+        };
+        PROFILE_ZONE("expose");
+        handleExpose(event);
+
+        m_GCCache.clearClip();
+    }
+
+    void App::backBufferPresent(const int winId, const std::span<const XRectangle> areas) const noexcept {
+        PROFILE_ZONE("present");
+        const auto it = m_BackBuffers.find(winId);
+        if (it == m_BackBuffers.end() || !windowCheckOpen(winId)) return;
+
+        const BackBuffer &buffer = it->second;
+        const Window window = m_Windows.at(winId);
+        if (buffer.isDbe) {
+            XdbeSwapInfo swapInfo{.swap_window = window, .swap_action = XdbeCopied};
+            XdbeSwapBuffers(m_Display, &swapInfo, 1);
+        } else {
+            const GC gc = gcGet(winId, {});
+            for (const XRectangle &area: areas)
+                XCopyArea(m_Display, buffer.drawable, window, gc, area.x, area.y, area.width, area.height, area.x,
+                          area.y);
+        }
+    }
+
+    void App::backBufferResize(const int winId, const unsigned int width, const unsigned int height) {
+        BackBuffer &buffer = m_BackBuffers.at(winId);
+        if (buffer.width == width && buffer.height == height && buffer.drawable != None) return;
+
+        buffer.width = width;
+        buffer.height = height;
+        if (buffer.isDbe) return;
+
+        if (buffer.drawable != None) XFreePixmap(m_Display, buffer.drawable);
+        buffer.drawable = XCreatePixmap(m_Display, m_Windows.at(winId), std::max(width, 1u), std::max(height, 1u),
+                                        DefaultDepth(m_Display, m_ScreenId));
+        windowClear(winId, false);
+        windowScheduleRedraw(winId);
+    }
+
+    void App::backBufferFree(const int winId) {
+        const BackBuffer buffer = m_BackBuffers.at(winId);
+        m_BackBuffers.erase(winId);
+
+        const Window window = m_Windows.at(winId);
+        if (buffer.isDbe) XdbeDeallocateBackBufferName(m_Display, buffer.drawable);
+        else XFreePixmap(m_Display, buffer.drawable);
+
+        const auto layer = m_Layers.find(winId);
+        if (buffer.ownsStructureMask) {
+            // a layer keeps tracking resizes with the mask the back buffer selected
+            if (layer != m_Layers.end()) layer->second.ownsStructureMask = true;
+            else {
+                XWindowAttributes attrs{};
+                XGetWindowAttributes(m_Display, window, &attrs);
+                XSelectInput(m_Display, window, attrs.your_event_mask & ~StructureNotifyMask);
+            }
+        }
+        XSetWindowBackground(m_Display, window, WhitePixel(m_Display, m_ScreenId));
+        if (layer != m_Layers.end() && layer->second.asBackground && layer->second.pixmap != None) {
+            XSetWindowBackgroundPixmap(m_Display, window, layer->second.pixmap);
+            layer->second.installed = true;
+        }
+    }
+
+    void App::layerSet(const int winId, LayerRender render, const bool asBackground) {
+        REQUIRE_WINDOW(winId, "Attempting to set a layer of a non-existent window ID " + std::to_string(winId))
+
+        layerRemove(winId);
+        Layer layer{.render = std::move(render), .asBackground = asBackground};
+        const auto attrs = windowGetAttributes(winId);
+        // only track resizes ourselves if the application and the back buffer did not ask for them
+        if (!(attrs.your_event_mask & StructureNotifyMask)) {
+            XSelectInput(m_Display, m_Windows.at(winId), attrs.your_event_mask | StructureNotifyMask);
+            layer.ownsStructureMask = true;
+        }
+        m_Layers[winId] = std::move(layer);
+        windowScheduleRedraw(winId);
+    }
+
+    void App::layerRemove(const int winId) {
+        const auto it = m_Layers.find(winId);
+        if (it == m_Layers.end()) return;
+        const Layer layer = std::move(it->second);
+        m_Layers.erase(it);
+
+        const Window window = m_Windows.at(winId);
+        if (layer.installed) XSetWindowBackground(m_Display, window, WhitePixel(m_Display, m_ScreenId));
+        if (layer.pixmap != None) XFreePixmap(m_Display, layer.pixmap);
+        if (layer.ownsStructureMask) {
+            // a back buffer keeps tracking resizes with the mask the layer selected
+            if (const auto buffer = m_BackBuffers.find(winId); buffer != m_BackBuffers.end())
+                buffer->second.ownsStructureMask = true;
+            else {
+                XWindowAttributes attrs{};
+                XGetWindowAttributes(m_Display, window, &attrs);
+                XSelectInput(m_Display, window, attrs.your_event_mask & ~StructureNotifyMask);
+            }
+        }
+        windowScheduleRedraw(winId);
+    }
+
+    void App::layerInvalidate(const int winId) noexcept {
+        const auto it = m_Layers.find(winId);
+        if (it == m_Layers.end()) return;
+        it->second.stale = true;
+        windowScheduleRedraw(winId);
+    }
+
+    void App::layerRender(const int winId) {
+        Layer &layer = m_Layers.at(winId);
+        const Window window = m_Windows.at(winId);
+        const auto attrs = windowGetAttributes(winId);
+        const auto width = static_cast<unsigned int>(std::max(attrs.width, 1));
+        const auto height = static_cast<unsigned int>(std::max(attrs.height, 1));
+        if (layer.pixmap == None || layer.width != width || layer.height != height) {
+            if (layer.pixmap != None) XFreePixmap(m_Display, layer.pixmap);
+            layer.pixmap = XCreatePixmap(m_Display, window, width, height, DefaultDepth(m_Display, m_ScreenId));
+            layer.width = width;
+            layer.height = height;
+        }
+
+        const GC gc = gcGet(winId, {.foreground = WhitePixel(m_Display, m_ScreenId)});
+        XFillRectangle(m_Display, layer.pixmap, gc, 0, 0, width, height);
+
+        // every draw function of the window targets the Pixmap while the layer renders
+        m_LayerTarget = layer.pixmap;
+        m_LayerWinId = winId;
+        try {
+            layer.render(winId, width, height);
+            batchSubmit();
+        } catch (...) {
+            m_LayerTarget = None;
+            throw;
+        }
+        m_LayerTarget = None;
+        layer.stale = false;
+
+        // the server may or may not copy a background Pixmap, so it is installed again after every render
+        layer.installed = layer.asBackground && !windowIsDoubleBuffered(winId);
+        if (layer.installed) XSetWindowBackgroundPixmap(m_Display, window, layer.pixmap);
+    }
+
+    void App::layerClear(const int winId, const Drawable target, const XRectangle &area) const noexcept {
+        const Window window = m_Windows.at(winId);
+        const auto it = m_Layers.find(winId);
+        if (it != m_Layers.end() && it->second.pixmap != None && !(it->second.installed && target == window)) {
+            XCopyArea(m_Display, it->second.pixmap, target, gcGet(winId, {}), area.x, area.y, area.width,
+                      area.height, area.x, area.y);
+        } else if (target == window) {
+            XClearArea(m_Display, window, area.x, area.y, area.width, area.height, False);
+        } else {
+            const GC gc = gcGet(winId, {.foreground = WhitePixel(m_Display, m_ScreenId)});
+            XFillRectangle(m_Display, target, gc, area.x, area.y, area.width, area.height);
+        }
+    }
+
     App::~App() {
 #if DEBUG
         std::cout << "Cleaning up " << m_Windows.size() << " windows" << std::endl;
 #endif
+        inputThreadStop();
+        while (!m_Images.empty()) imageRelease(m_Images.begin()->first);
+        while (!m_BackBuffers.empty()) backBufferFree(m_BackBuffers.begin()->first);
+        while (!m_Layers.empty()) layerRemove(m_Layers.begin()->first);
+        m_GCCache.clear();
+        m_FontCache.clear();
         for (const Window window: m_Windows | std::views::values) XDestroyWindow(m_Display, window);
         if (m_Display) XCloseDisplay(m_Display);
+        if (m_FrameWakeFd >= 0) close(m_FrameWakeFd);
     }
 }
@@ -5,21 +5,35 @@
 #ifndef X11TEST_APP_H
 #define X11TEST_APP_H
 
+#include <atomic>
 #include <future>
 #include <iostream>
 #include <map>
 #include <memory>
-#include <queue>
+#include <span>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include <sys/eventfd.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/keysym.h>
 
+#include "lib/AllocTracker.h"
 #include "lib/AtomManager.h"
+#include "lib/BackBuffer.h"
+#include "lib/DamageRegion.h"
+#include "lib/DrawBatch.h"
+#include "lib/FontCache.h"
 #include "lib/FontDescriptor.h"
+#include "lib/FrameLoop.h"
+#include "lib/GCCache.h"
+#include "lib/InputQueue.h"
 #include "lib/KeyStateManager.h"
+#include "lib/Layer.h"
+#include "lib/Profiler.h"
+#include "lib/ShmImage.h"
 
 using u16 = unsigned short;
 using PixelPos = unsigned short;
@@ -31,12 +45,43 @@ namespace X11App {
         Display *m_Display = nullptr;
         int m_ScreenId;
         std::map<int, Window> m_Windows;
+        std::map<int, BackBuffer> m_BackBuffers{};
+        std::map<int, Layer> m_Layers{};
+        Drawable m_LayerTarget = None; // draw functions target this Pixmap while a layer of m_LayerWinId renders
+        int m_LayerWinId = 0;
         KeyStateManager m_KeyStateManager;
-        std::queue<int> m_RedrawQueue{};
+        std::map<int, DamageRegion> m_Damage{};
+        std::vector<XRectangle> m_DamageScratch{};
         AtomManager m_AtomManager;
+        mutable GCCache m_GCCache;
+        mutable FontCache m_FontCache;
+        DrawBatch m_Batch{};
+        std::map<int, std::unique_ptr<ShmImage>> m_Images{};
+        int m_ShmCompletionType;
+        FrameStats m_FrameStats{};
+        bool m_FrameLoopRunning = false;
+        bool m_FixedStepEnabled = true;
+        int m_FrameWakeFd; // signalled by frameWake
+
+        std::thread m_InputThread{};
+        std::atomic<bool> m_InputThreadStop{false};
+        std::atomic<uint64_t> m_InputFullStalls{0};
+        std::unique_ptr<InputQueue> m_InputQueue{};
+        std::vector<QueuedEvent> m_DeferredEvents{}; // taken off the queue while waiting for something else
+        InputQueueStats m_InputStats{};
+        int m_InputEventFd = -1; // signalled by the input thread after every pushed event
+        Window m_InputWakeWindow = None; // target of the ClientMessage that wakes the input thread for stopping
+
+        inline static bool s_ThreadsInitialised = false;
 
         explicit App(Display *display) : m_Display(display),
-                                         m_ScreenId(DefaultScreen(display)), m_AtomManager(display) {
+                                         m_ScreenId(DefaultScreen(display)), m_KeyStateManager(display),
+                                         m_AtomManager(display),
+                                         m_GCCache(display), m_FontCache(display),
+                                         m_ShmCompletionType(XShmQueryExtension(display)
+                                                                 ? XShmGetEventBase(display) + ShmCompletion
+                                                                 : -1),
+                                         m_FrameWakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
         }
 
         // |*********************************************|
@@ -83,7 +128,8 @@ namespace X11App {
         /// @param flush If true, flush the display after clearing. Flushing ensures that the clear operation is sent to the X server immediately.
         void windowClear(int winId, bool flush) const noexcept;
 
-        /// Force a redraw of all windows by calling handleExpose with an empty event.
+        /// Force a redraw of the whole window by calling handleExpose with an event covering DamageRegion::everything.
+        /// Does not clear the window or present the back buffer.
         /// @param winId The ID of the window to redraw.
         void windowForceRedraw(int winId) noexcept;
 
@@ -102,15 +148,81 @@ namespace X11App {
         /// @return An optional containing the window ID if found, or std::nullopt if not found.
         [[nodiscard]] std::optional<int> windowRawToId(Window window) const;
 
-        /// Schedule a redraw of the specified window by adding it to the redraw queue.
-        /// The actual redraw will be processed later when windowProcessRedrawQueue is called.
+        /// Schedule a redraw of the whole window by adding it to the window's damage region.
+        /// The actual redraw will be processed later when windowProcessRedrawQueue is called. Scheduling the same
+        /// window multiple times before that results in a single redraw.
         /// @warning Do not call this within the handleExpose event handler to avoid infinite redraw loops.
         /// @param winId The ID of the window to schedule for redraw.
-        inline void windowScheduleRedraw(const int winId) noexcept { m_RedrawQueue.push(winId); };
+        inline void windowScheduleRedraw(const int winId) noexcept { m_Damage[winId].add(DamageRegion::everything); };
 
-        /// Process all windows in the redraw queue by calling windowClear and windowForceRedraw on each.
+        /// Schedule a redraw of part of the specified window by adding the area to the window's damage region.
+        /// Overlapping and touching areas are merged.
+        /// @warning Do not call this within the handleExpose event handler to avoid infinite redraw loops.
+        /// @param winId The ID of the window to schedule for redraw.
+        /// @param area The area to redraw in window coordinates.
+        inline void windowScheduleRedraw(const int winId, const XRectangle &area) noexcept {
+            m_Damage[winId].add(area);
+        };
+
+        /// Redraw the damaged areas of all windows. Each rectangle of a damage region is cleared and passed to
+        /// handleExpose as the event's x/y/width/height, with all drawing clipped to it. Like server exposures, count
+        /// holds the number of rectangles that follow for the same window. Double buffered windows are presented
+        /// afterwards. Expose events of single buffered windows are merged into the damage region as well.
         void windowProcessRedrawQueue() noexcept;
 
+        /// Enable or disable double buffering for the specified window. While enabled, all draw functions and
+        /// windowClear target an off-screen back buffer, which windowProcessRedrawQueue presents in one step.
+        /// Server side exposures are repaired from the back buffer without calling handleExpose.
+        /// @param winId The ID of the window to change.
+        /// @param enabled True to allocate a back buffer, false to free it and draw directly to the window again.
+        /// @param preferDbe If true and the DBE extension supports the window's visual, use a DBE back buffer
+        /// instead of a Pixmap.
+        /// @throws std::runtime_error if the window ID does not exist.
+        void windowSetDoubleBuffered(int winId, bool enabled, bool preferDbe = true);
+
+        /// @param winId The ID of the window to check.
+        /// @return True if the window has a back buffer, false otherwise.
+        [[nodiscard]] bool windowIsDoubleBuffered(int winId) const noexcept { return m_BackBuffers.contains(winId); }
+
+        /// Copy the back buffer of the specified window to the screen. Does nothing for single buffered windows.
+        /// Only needed when drawing outside of windowProcessRedrawQueue.
+        /// @param winId The ID of the window to present.
+        void windowPresent(int winId) const noexcept;
+
+        /// Copy parts of the back buffer of the specified window to the screen, e.g. after drawing only what changed
+        /// outside of windowProcessRedrawQueue. DBE back buffers are swapped as a whole. Does nothing for single
+        /// buffered windows.
+        /// @param winId The ID of the window to present.
+        /// @param areas The areas to copy in window coordinates.
+        void windowPresent(const int winId, const std::span<const XRectangle> areas) const noexcept {
+            backBufferPresent(winId, areas);
+        }
+
+        /// Give the specified window a static layer, replacing the one it had. The layer is rendered into a Pixmap
+        /// before the next redraw, with all draw functions and batches of the window targeting the Pixmap, which
+        /// starts out white. From then on every cleared area of the window shows the layer, and it is only rendered
+        /// again when the window size changes or layerInvalidate is called.
+        /// @param winId The ID of the window.
+        /// @param render Draws the layer.
+        /// @param asBackground If true, install the Pixmap as the window background with XSetWindowBackgroundPixmap
+        /// while the window is single buffered, so the server repaints exposed areas without a round trip. Back
+        /// buffers have no background, they are cleared with a copy of the Pixmap instead.
+        /// @throws std::runtime_error if the window ID does not exist.
+        void layerSet(int winId, LayerRender render, bool asBackground = true);
+
+        /// Remove the layer of the specified window and free its Pixmap. Does nothing if it has none.
+        /// @param winId The ID of the window.
+        void layerRemove(int winId);
+
+        /// Render the layer of the specified window again before the next redraw and redraw the whole window, e.g.
+        /// after the content it depends on changed. Does nothing if it has none.
+        /// @param winId The ID of the window.
+        void layerInvalidate(int winId) noexcept;
+
+        /// @param winId The ID of the window to check.
+        /// @return True if the window has a layer.
+        [[nodiscard]] bool layerHas(const int winId) const noexcept { return m_Layers.contains(winId); }
+
         //|*********************************************|
         //|                  Drawing                    |
         //|*********************************************|
@@ -150,8 +262,17 @@ namespace X11App {
         /// @param fontStr The X-Logical-Font-Description of the font.
         /// @param text The text to draw.
         /// @throws std::runtime_error if the window ID does not exist.
+        /// @throws std::runtime_error if the font cannot be loaded.
         void drawText(int winId, const XColor &color, PixelPos x, PixelPos y, str fontStr, str text) const;
 
+        /// Measure text as drawText would draw it. Uses the cached glyph metrics, so there is no server round trip
+        /// after the font has been used once.
+        /// @param fontStr The X-Logical-Font-Description of the font.
+        /// @param text The text to measure.
+        /// @return The width, ascent and descent of the text in pixels.
+        /// @throws std::runtime_error if the font cannot be loaded.
+        [[nodiscard]] TextExtents textMeasure(str fontStr, str text) const { return m_FontCache.measure(fontStr, text); }
+
         /// Draw a filled polygon on the specified window.
         /// @param winId The ID of the window to draw on.
         /// @param color The color to use for drawing.
@@ -170,13 +291,132 @@ namespace X11App {
         /// @throws std::runtime_error if the window ID does not exist.
         void drawLine(int winId, const XColor &color, PixelPos x1, PixelPos y1, PixelPos x2, PixelPos y2) const;
 
+        /// Start recording primitives for the specified window. Primitives are grouped by color and sent with one
+        /// XFillRectangles/XDrawSegments/XFillArcs/XDrawPoints request per color on batchSubmit, instead of one
+        /// request per primitive. Anything recorded but not yet submitted is dropped.
+        /// The grouping gives up the recording order: colors are sent in ascending pixel value, and within a color
+        /// rectangles, then segments, arcs and points. Where primitives of different colors or kinds overlap and
+        /// the one on top matters, submit them in separate batches in the order they have to be drawn.
+        /// @param winId The ID of the window to draw on.
+        /// @return The batch to record primitives into. Valid until the next batchBegin.
+        /// @throws std::runtime_error if the window ID does not exist.
+        DrawBatch &batchBegin(int winId);
+
+        /// Send every primitive recorded since batchBegin, splitting requests at the server's max request size.
+        /// Does nothing if no batch is active or the window has been closed in the meantime.
+        void batchSubmit();
+
+        /// Hit/miss counters of the graphics context cache used by all draw functions.
+        /// @return The current GCCacheStats.
+        [[nodiscard]] const GCCacheStats &gcCacheStats() const noexcept { return m_GCCache.stats(); }
+
+        /// Reset the hit/miss counters of the graphics context cache, e.g. at the start of a frame.
+        void gcCacheResetStats() const noexcept { m_GCCache.resetStats(); }
+
+        // |*********************************************|
+        // |                    Image                    |
+        // |*********************************************|
+
+        /// Get the pixel buffer of the specified window, (re)allocating it if the size changed. The buffer lives in
+        /// a MIT-SHM segment when the extension is usable, so imagePresent does not copy the pixels through the
+        /// socket. Blocks until the server is done reading the previous frame.
+        /// @param winId The ID of the window the image belongs to.
+        /// @param width The width of the image in pixels.
+        /// @param height The height of the image in pixels.
+        /// @return A writable view of the pixels, valid until the next imageAcquire, imageRelease or windowClose.
+        /// Pixel values can be created with imagePack.
+        /// @throws std::runtime_error if the window ID does not exist or the visual is not 32 bits per pixel.
+        ImageView imageAcquire(int winId, u16 width, u16 height);
+
+        /// Upload the pixel buffer of the specified window to its drawable (the back buffer if double buffered).
+        /// @param winId The ID of the window the image belongs to.
+        /// @param x The X position of the top-left corner of the image.
+        /// @param y The Y position of the top-left corner of the image.
+        /// @throws std::runtime_error if the window has no image.
+        void imagePresent(int winId, PixelPos x, PixelPos y);
+
+        /// Free the pixel buffer of the specified window. Does nothing if it has none.
+        /// @param winId The ID of the window the image belongs to.
+        void imageRelease(int winId) noexcept;
+
+        /// Pack 8 bit color components into a pixel value for the image of the specified window.
+        /// @throws std::runtime_error if the window has no image.
+        [[nodiscard]] uint32_t imagePack(int winId, uint8_t red, uint8_t green, uint8_t blue) const;
+
+        /// @return True if images are uploaded through MIT-SHM, false if they fall back to XPutImage.
+        [[nodiscard]] bool imageUsesShm(int winId) const noexcept {
+            const auto it = m_Images.find(winId);
+            return it != m_Images.end() && it->second->usesShm();
+        }
+
         // todo: Make it possible to draw images https://stackoverflow.com/questions/6609281/how-to-draw-an-image-from-file-on-window-with-xlib
         // void drawImage(int winId, int x, int y, const str path) const;
 
+        // |*********************************************|
+        // |                 Frame Loop                  |
+        // |*********************************************|
+
+        /// Run an event driven main loop until frameLoopStop is called. The loop blocks in poll on the X connection
+        /// and a timerfd, so input is handled the moment it arrives and nothing runs while there is nothing to do.
+        /// Each iteration handles all queued events, runs the due frameFixedStep calls, calls frameUpdate and redraws
+        /// damaged windows, at most config.targetFps times per second.
+        /// @param config The timing configuration of the loop.
+        /// @throws std::runtime_error if the timer cannot be created.
+        void frameLoopRun(const FrameLoopConfig &config);
+
+        /// Make frameLoopRun return after the current iteration.
+        void frameLoopStop() noexcept { m_FrameLoopRunning = false; }
+
+        /// Wake frameLoopRun from its poll so it runs another iteration, e.g. when a worker thread produced something
+        /// for frameUpdate to pick up. Safe to call from any thread, also while the loop is not running.
+        void frameWake() const noexcept;
+
+        /// Pause or resume the fixed step simulation, e.g. while the app is paused. While disabled no timer is armed
+        /// for it and time does not accumulate.
+        /// @param enabled False to stop calling frameFixedStep.
+        void frameSetFixedStepEnabled(const bool enabled) noexcept { m_FixedStepEnabled = enabled; }
+
+        /// @return Timing statistics of frameLoopRun.
+        [[nodiscard]] const FrameStats &frameStats() const noexcept { return m_FrameStats; }
+
+        /// Called by frameLoopRun every FrameLoopConfig::fixedStepMs milliseconds of elapsed time. Default does nothing.
+        virtual void frameFixedStep() {
+        }
+
+        /// Called by frameLoopRun once per iteration, after events and fixed steps and before redrawing.
+        /// Default does nothing.
+        virtual void frameUpdate() {
+        }
+
+        // |*********************************************|
+        // |                 Input Thread                |
+        // |*********************************************|
+
+        /// Start a dedicated thread that reads events from the X connection into a lock-free queue, so reading
+        /// input never waits for simulation or rendering. handleAllQueuedEvents and frameLoopRun then consume the
+        /// queue in batches on the calling thread, which is also where all handlers keep running.
+        /// Requires the App to be created with Create<TDerived>(true). Does nothing if the thread is running.
+        /// @throws std::runtime_error if Xlib was not initialised for threads.
+        void inputThreadStart();
+
+        /// Stop the input thread and wait for it to exit. Events still in the queue are handled by the next
+        /// handleAllQueuedEvents. Does nothing if the thread is not running.
+        void inputThreadStop() noexcept;
+
+        /// @return True if events are read by the input thread.
+        [[nodiscard]] bool inputThreaded() const noexcept { return m_InputThread.joinable(); }
+
+        /// @return Queue depth, event age and stall metrics of the threaded input mode.
+        [[nodiscard]] InputQueueStats inputStats() const noexcept {
+            InputQueueStats stats = m_InputStats;
+            stats.fullStalls = m_InputFullStalls.load(std::memory_order_relaxed);
+            return stats;
+        }
+
         // |*********************************************|
         // |                Event Handling               |
         // |*********************************************|
-        /// Process all pending X events by retrieving them from the X server and dispatching them to the appropriate handler functions.
+        /// Process all pending X events by retrieving them from the X server (or the input thread's queue) and dispatching them to the appropriate handler functions.
         void handleAllQueuedEvents();
 
         /// Dispatch the given XEvent to the appropriate handler function based on its type. Uses a non const reference to allow more flexibility in handling.
@@ -200,7 +440,6 @@ namespace X11App {
         HANDLE_EVENT_FUNC_TEMPLATE(LeaveNotify, LeaveWindow)
         HANDLE_EVENT_FUNC_TEMPLATE(FocusIn, FocusIn)
         HANDLE_EVENT_FUNC_TEMPLATE(FocusOut, FocusOut)
-        HANDLE_EVENT_FUNC_TEMPLATE(MappingNotify, Mapping)
         HANDLE_EVENT_FUNC_TEMPLATE(ConfigureNotify, Configure)
         HANDLE_EVENT_FUNC_TEMPLATE(UnmapNotify, Unmap)
         HANDLE_EVENT_FUNC_TEMPLATE(MapNotify, Map)
@@ -228,6 +467,11 @@ namespace X11App {
         /// @param event The XKeyEvent to handle.
         virtual void handleKeyRelease(XKeyEvent &event);
 
+        /// Handle a mapping change. Default implementation refreshes Xlib's mapping and, for keyboard changes, the
+        /// KeySym tables of the KeyStateManager.
+        /// @param event The XMappingEvent to handle.
+        virtual void handleMappingNotify(XMappingEvent &event);
+
         virtual void handleClientMessage(XClientMessageEvent &event);
 
         // |*********************************************|
@@ -252,13 +496,18 @@ namespace X11App {
         /// @return True if the key is currently held down, false otherwise.
         inline bool keyIsDown(const KeySym key) const { return m_KeyStateManager.isKeyDown(key); };
 
-        /// Wrapper for m_KeyStateManager.isKeyPressed. Is not const because of the isKeyPressed implementation
+        /// Wrapper for m_KeyStateManager.isKeyPressed. The frame loop advances the key state once per iteration.
+        /// @param key The KeySym to check.
+        /// @return True if the key went down since the last iteration of the frame loop, false otherwise.
+        inline bool keyIsPressed(const KeySym key) const { return m_KeyStateManager.isKeyPressed(key); };
+
+        /// Wrapper for m_KeyStateManager.isKeyReleased
         /// @param key The KeySym to check.
-        /// @return True if the key was just pressed (transitioned from up to down), false otherwise.
-        inline bool keyIsPressed(const KeySym key) { return m_KeyStateManager.isKeyPressed(key); };
+        /// @return True if the key went up since the last iteration of the frame loop, false otherwise.
+        inline bool keyIsReleased(const KeySym key) const { return m_KeyStateManager.isKeyReleased(key); };
 
         /// Wrapper for m_KeyStateManager.stateChanged
-        /// @return True if the current state and the previous state differ, false otherwise.
+        /// @return True if any key went down or up since the last iteration of the frame loop, false otherwise.
         inline bool keyStateChanged() const { return m_KeyStateManager.stateChanged(); };
 
     private:
@@ -266,6 +515,60 @@ namespace X11App {
         // |               Helper Functions              |
         // |*********************************************|
 
+        /// @param winId The ID of the window to draw on. Must be open.
+        /// @return The back buffer of the window if it is double buffered, the window itself otherwise.
+        [[nodiscard]] Drawable windowDrawable(int winId) const;
+
+        /// (Re)allocate the Pixmap back buffer of the specified window if its size changed. Does nothing for DBE.
+        void backBufferResize(int winId, unsigned int width, unsigned int height);
+
+        /// Clear the given area of the specified window and let handleExpose redraw it, clipped to the area.
+        /// @param winId The ID of the window to redraw. Must be open.
+        /// @param area The area to redraw.
+        /// @param count The number of areas that will follow for the same window.
+        void windowRedrawArea(int winId, const XRectangle &area, int count) noexcept;
+
+        /// Copy parts of the back buffer of the specified window to the screen. DBE back buffers are swapped once
+        /// as a whole. Does nothing for single buffered windows.
+        void backBufferPresent(int winId, std::span<const XRectangle> areas) const noexcept;
+
+        /// Free the server side resources of a back buffer and restore the window background.
+        void backBufferFree(int winId);
+
+        /// (Re)allocate the Pixmap of the layer of the specified window to the window size and render into it.
+        void layerRender(int winId);
+
+        /// Fill the area of the drawable with the layer of the specified window, or the background color without
+        /// one. Single buffered windows with an installed layer are cleared by the server instead.
+        void layerClear(int winId, Drawable target, const XRectangle &area) const noexcept;
+
+        /// Block until the server finished reading the image of the specified window.
+        void imageWaitCompletion(int winId);
+
+        /// Body of the input thread.
+        void inputThreadLoop();
+
+        /// Take the next event off the input thread's queue, or the deferred events first.
+        /// @return False if there is no event.
+        bool inputQueuePop(QueuedEvent &out) noexcept;
+
+        /// Block until the input thread signals a new event or the timeout expires.
+        void inputQueueWait(int timeoutMs) const noexcept;
+
+        /// @return True if any window has a non empty damage region.
+        [[nodiscard]] bool windowAnyDamaged() const noexcept;
+
+        /// Bookkeeping the App does for itself before an event is dispatched to the handlers.
+        /// @param event The event to inspect.
+        /// @return True if the event was consumed and must not be dispatched.
+        bool handleInternalEvent(XEvent &event);
+
+        /// Get a cached GC for the specified window and state. Creates it on first use.
+        /// @param winId The ID of the window to get the GC for. Must be open.
+        /// @param state The GC state to look up.
+        /// @return A GC owned by m_GCCache, do not free.
+        GC gcGet(int winId, const GCState &state) const { return m_GCCache.get(winId, m_Windows.at(winId), state); }
+
         /// Triggers a debug trap if DEBUG is defined.
         /// @param message Optional message to print before trapping.
         static void debug_trap(const char *message [[maybe_unused]] = nullptr) {
@@ -300,17 +603,25 @@ namespace X11App {
          * A static factory method to create an instance of a class derived from App. Creates and opens a connection to the X server.
          *
          * @tparam TDerived The type of the derived class that inherits from App. This class must also friend App.
+         * @tparam Args Types of additional constructor arguments of TDerived.
+         * @param initThreads If true, call XInitThreads before opening the display, which is required for inputThreadStart.
+         * @param args Additional arguments passed to the TDerived constructor after the display.
          * @return A unique_ptr to the created instance of TDerived.
          * @throws std::runtime_error if the display cannot be opened.
          */
-        template<class TDerived>
-        static std::unique_ptr<App> Create() {
+        template<class TDerived, typename... Args>
+        static std::unique_ptr<App> Create(const bool initThreads = false, Args &&... args) {
             static_assert(std::is_base_of_v<App, TDerived>, "Type TDerived must derive from App");
 
+            if (initThreads && !s_ThreadsInitialised) {
+                if (!XInitThreads()) throw std::runtime_error("Xlib does not support threads");
+                s_ThreadsInitialised = true;
+            }
+
             Display *display = XOpenDisplay(nullptr);
             if (!display) throw std::runtime_error("Cannot open display");
 
-            return std::unique_ptr<App>(new TDerived(display));
+            return std::unique_ptr<App>(new TDerived(display, std::forward<Args>(args)...));
         }
 
         /// The main application loop. Must be implemented by derived classes.
@@ -0,0 +1,71 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_ALLOCTRACKER_H
+#define X11TEST_ALLOCTRACKER_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace X11App {
+    /**
+     * Allocation tracker. Building core/AllocTracker.cpp with TRACK_ALLOCATIONS set replaces every form of global
+     * operator new and delete (plain, array, aligned, sized and nothrow) with versions that count into per-thread,
+     * cache line sized slots with relaxed atomics. They never print, lock or allocate, so tracking is safe on any
+     * thread and costs a few atomic adds per allocation. Without TRACK_ALLOCATIONS the functions below report
+     * nothing and the standard operators are used.
+     */
+#if TRACK_ALLOCATIONS
+    constexpr bool allocTracking = true;
+#else
+    constexpr bool allocTracking = false;
+#endif
+
+    /// Size classes of the histogram: class i holds requests of up to 16 << i bytes, the last one everything
+    /// larger.
+    constexpr size_t allocSizeClasses = 20;
+
+    /// @return The histogram class of a request of size bytes.
+    constexpr size_t allocSizeClass(const size_t size) noexcept {
+        size_t sizeClass = 0;
+        while (sizeClass + 1 < allocSizeClasses && size > size_t{16} << sizeClass) sizeClass++;
+        return sizeClass;
+    }
+
+    /// Totals of all threads, including those that have exited.
+    struct AllocStats {
+        uint64_t allocations = 0, frees = 0;
+        uint64_t requestedBytes = 0; // sum of the sizes passed to operator new
+        int64_t liveBytes = 0; // usable size of the blocks not freed yet, as reported by malloc
+        std::array<uint64_t, allocSizeClasses> sizeClasses{}; // allocations per size class
+    };
+
+    /// A sampled call site: the three innermost frames above operator new.
+    struct AllocSite {
+        std::array<void *, 3> frames{};
+        uint64_t samples = 0, bytes = 0;
+    };
+
+    [[nodiscard]] AllocStats allocStats() noexcept;
+
+    /// @return Allocations made by the calling thread so far. Differences of two calls count the allocations of
+    /// the code in between, e.g. of a frame.
+    [[nodiscard]] uint64_t allocThreadCount() noexcept;
+
+    /**
+     * Record the call site of every n-th allocation of each thread, 0 turns sampling off. Sites are kept in a
+     * fixed table, samples of new sites are dropped once it is full.
+     */
+    void allocSampleEvery(uint32_t n) noexcept;
+
+    /// @return The sampled call sites, most samples first.
+    [[nodiscard]] std::vector<AllocSite> allocSites();
+
+    /// Write the totals, the size class histogram and the top sampled call sites.
+    void allocReport(std::ostream &out, size_t topSites = 10);
+}
+
+#endif //X11TEST_ALLOCTRACKER_H
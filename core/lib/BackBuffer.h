@@ -0,0 +1,23 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BACKBUFFER_H
+#define X11TEST_BACKBUFFER_H
+#include <X11/Xlib.h>
+
+namespace X11App {
+    /**
+     * Off-screen target of a double buffered window. All draw functions render into drawable, and the frame is
+     * presented with a single XCopyArea (Pixmap) or XdbeSwapBuffers (DBE back buffer).
+     */
+    struct BackBuffer {
+        Drawable drawable = None;
+        bool isDbe = false; // drawable is an XdbeBackBuffer, which follows the window size on its own
+        bool ownsStructureMask = false; // StructureNotifyMask was only selected to track resizes
+        unsigned int width = 0;
+        unsigned int height = 0;
+    };
+}
+
+#endif //X11TEST_BACKBUFFER_H
@@ -0,0 +1,76 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_DAMAGEREGION_H
+#define X11TEST_DAMAGEREGION_H
+#include <algorithm>
+#include <vector>
+#include <X11/Xlib.h>
+
+namespace X11App {
+    /**
+     * Area of a window that has to be redrawn, kept as a short list of disjoint rectangles.
+     * Overlapping or touching rectangles are merged into their bounding box, and once more than maxRects
+     * rectangles accumulate everything collapses into a single bounding box, so redraw cost stays bounded.
+     */
+    class DamageRegion {
+        static constexpr size_t maxRects = 16;
+        std::vector<XRectangle> m_Rects{};
+
+        static bool touches(const XRectangle &a, const XRectangle &b) noexcept {
+            return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+        }
+
+        static XRectangle unite(const XRectangle &a, const XRectangle &b) noexcept {
+            const int x1 = std::min(a.x, b.x), y1 = std::min(a.y, b.y);
+            const int x2 = std::max(a.x + a.width, b.x + b.width), y2 = std::max(a.y + a.height, b.y + b.height);
+            return {
+                static_cast<short>(x1), static_cast<short>(y1), static_cast<unsigned short>(x2 - x1),
+                static_cast<unsigned short>(y2 - y1)
+            };
+        }
+
+    public:
+        /// A rectangle large enough to cover any window, used to damage a window completely.
+        static constexpr XRectangle everything{0, 0, 0x7FFF, 0x7FFF};
+
+        /// Add a rectangle to the region, merging it with every rectangle it overlaps or touches.
+        void add(XRectangle rect) {
+            if (rect.width == 0 || rect.height == 0) return;
+
+            // merging can make the result touch rectangles that were checked before, so repeat until stable
+            for (bool merged = true; merged;) {
+                merged = false;
+                for (auto it = m_Rects.begin(); it != m_Rects.end(); ++it) {
+                    if (!touches(*it, rect)) continue;
+                    rect = unite(*it, rect);
+                    m_Rects.erase(it);
+                    merged = true;
+                    break;
+                }
+            }
+            m_Rects.push_back(rect);
+
+            if (m_Rects.size() > maxRects) {
+                const XRectangle box = bounds();
+                m_Rects.assign(1, box);
+            }
+        }
+
+        /// @return The bounding box of the whole region, or an empty rectangle if the region is empty.
+        [[nodiscard]] XRectangle bounds() const noexcept {
+            if (m_Rects.empty()) return {0, 0, 0, 0};
+            XRectangle box = m_Rects.front();
+            for (const XRectangle &r: m_Rects) box = unite(box, r);
+            return box;
+        }
+
+        [[nodiscard]] const std::vector<XRectangle> &rects() const noexcept { return m_Rects; }
+        [[nodiscard]] bool empty() const noexcept { return m_Rects.empty(); }
+
+        void clear() noexcept { m_Rects.clear(); }
+    };
+}
+
+#endif //X11TEST_DAMAGEREGION_H
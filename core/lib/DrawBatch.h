@@ -0,0 +1,98 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_DRAWBATCH_H
+#define X11TEST_DRAWBATCH_H
+#include <map>
+#include <ranges>
+#include <vector>
+#include <X11/Xlib.h>
+
+namespace X11App {
+    /**
+     * Command buffer for primitives of one window. Primitives are grouped by color into contiguous XRectangle,
+     * XSegment, XArc and XPoint arrays so App::batchSubmit can send each group with a single poly request
+     * instead of one request per primitive. The order primitives were recorded in is not kept across colors and
+     * kinds, see App::batchBegin.
+     *
+     * Buckets keep their capacity across frames, so a steady scene does not allocate after the first frame.
+     */
+    class DrawBatch {
+    public:
+        struct Bucket {
+            std::vector<XRectangle> rectangles{}; // filled
+            std::vector<XSegment> segments{};
+            std::vector<XArc> arcs{}; // filled
+            std::vector<XPoint> points{};
+
+            [[nodiscard]] bool empty() const noexcept {
+                return rectangles.empty() && segments.empty() && arcs.empty() && points.empty();
+            }
+
+            void clear() noexcept {
+                rectangles.clear();
+                segments.clear();
+                arcs.clear();
+                points.clear();
+            }
+        };
+
+    private:
+        int m_WinId = 0;
+        bool m_Active = false;
+        std::map<unsigned long, Bucket> m_Buckets{}; // keyed by pixel value
+
+        Bucket &bucket(const XColor &color) { return m_Buckets[color.pixel]; }
+
+    public:
+        /// Start recording for the given window, dropping anything that was not submitted.
+        void begin(const int winId) noexcept {
+            clear();
+            m_WinId = winId;
+            m_Active = true;
+        }
+
+        /// Drop all recorded primitives but keep the allocated capacity.
+        void clear() noexcept {
+            for (Bucket &b: m_Buckets | std::views::values) b.clear();
+            m_Active = false;
+        }
+
+        [[nodiscard]] int winId() const noexcept { return m_WinId; }
+        [[nodiscard]] bool active() const noexcept { return m_Active; }
+        [[nodiscard]] const std::map<unsigned long, Bucket> &buckets() const noexcept { return m_Buckets; }
+
+        // coordinates are taken as int for convenience and narrowed to the 16 bit protocol types here
+
+        DrawBatch &rectangle(const XColor &color, const int x, const int y, const int width = 1, const int height = 1) {
+            bucket(color).rectangles.push_back({
+                static_cast<short>(x), static_cast<short>(y), static_cast<unsigned short>(width),
+                static_cast<unsigned short>(height)
+            });
+            return *this;
+        }
+
+        DrawBatch &line(const XColor &color, const int x1, const int y1, const int x2, const int y2) {
+            bucket(color).segments.push_back({
+                static_cast<short>(x1), static_cast<short>(y1), static_cast<short>(x2), static_cast<short>(y2)
+            });
+            return *this;
+        }
+
+        DrawBatch &circle(const XColor &color, const int x, const int y, const int radius = 10) {
+            const auto d = static_cast<unsigned short>(radius * 2);
+            bucket(color).arcs.push_back({
+                static_cast<short>(x - radius), static_cast<short>(y - radius), d, d, 0, 360 * 64
+            });
+            return *this;
+        }
+
+        DrawBatch &point(const XColor &color, const int x, const int y) {
+            bucket(color).points.push_back({static_cast<short>(x), static_cast<short>(y)});
+            return *this;
+        }
+    };
+}
+
+#endif //X11TEST_DRAWBATCH_H
@@ -0,0 +1,88 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_FONTCACHE_H
+#define X11TEST_FONTCACHE_H
+#include <climits>
+#include <map>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <X11/Xlib.h>
+
+namespace X11App {
+    /// Client side text metrics, all values in pixels.
+    struct TextExtents {
+        int width = 0; // logical advance width of the whole string
+        int ascent = 0; // distance from the baseline to the top of the font
+        int descent = 0; // distance from the baseline to the bottom of the font
+        int lbearing = 0; // leftmost ink pixel relative to the origin
+        int rbearing = 0; // rightmost ink pixel relative to the origin
+
+        [[nodiscard]] int height() const noexcept { return ascent + descent; }
+    };
+
+    /**
+     * Keeps every font that has been used alive for the lifetime of the cache, keyed by its XLFD string.
+     * XLoadQueryFont also transfers the per glyph metrics, so measuring text never needs a server round trip.
+     */
+    class FontCache {
+        Display *m_Display;
+        std::map<std::string, XFontStruct *, std::less<>> m_Fonts{};
+
+    public:
+        explicit FontCache(Display *display) : m_Display(display) {
+        }
+
+        FontCache(const FontCache &) = delete;
+
+        FontCache &operator=(const FontCache &) = delete;
+
+        ~FontCache() { clear(); }
+
+        /// Get the font with the given XLFD string, loading it on first use.
+        /// @param xlfd The X-Logical-Font-Description of the font, e.g. from FontDescriptor::toString().
+        /// @return The cached XFontStruct. Owned by the cache, do not free.
+        /// @throws std::runtime_error if no font matches the description.
+        const XFontStruct &get(const std::string_view xlfd) {
+            if (const auto it = m_Fonts.find(xlfd); it != m_Fonts.end()) return *it->second;
+
+            std::string key(xlfd);
+            XFontStruct *font = XLoadQueryFont(m_Display, key.c_str());
+            if (!font) throw std::runtime_error("Failed to load font " + key);
+
+            return *m_Fonts.emplace(std::move(key), font).first->second;
+        }
+
+        /// Measure a string using the cached glyph metrics. Does not contact the X server.
+        /// @param xlfd The X-Logical-Font-Description of the font.
+        /// @param text The text to measure.
+        /// @return The extents of the text.
+        TextExtents measure(const std::string_view xlfd, const std::string_view text) {
+            const XFontStruct &font = get(xlfd);
+            if (text.empty() || text.size() >= INT_MAX)
+                return {.width = 0, .ascent = font.ascent, .descent = font.descent, .lbearing = 0, .rbearing = 0};
+
+            int direction, ascent, descent;
+            XCharStruct overall{};
+            XTextExtents(const_cast<XFontStruct *>(&font), text.data(), static_cast<int>(text.size()), &direction,
+                         &ascent, &descent, &overall);
+
+            return {
+                .width = overall.width, .ascent = ascent, .descent = descent, .lbearing = overall.lbearing,
+                .rbearing = overall.rbearing
+            };
+        }
+
+        /// Free every loaded font. Must be called before the display is closed.
+        void clear() {
+            if (!m_Display) return;
+            for (XFontStruct *font: m_Fonts | std::views::values) XFreeFont(m_Display, font);
+            m_Fonts.clear();
+        }
+    };
+}
+
+#endif //X11TEST_FONTCACHE_H
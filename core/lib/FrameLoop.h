@@ -0,0 +1,69 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_FRAMELOOP_H
+#define X11TEST_FRAMELOOP_H
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace X11App {
+    struct FrameLoopConfig {
+        /// Upper bound for presented frames per second. 0 presents as soon as something was damaged.
+        int targetFps = 60;
+        /// Interval of App::frameFixedStep in milliseconds. 0 disables fixed step simulation.
+        int fixedStepMs = 0;
+        /// Maximum number of fixed steps run in one iteration. Keeps a slow step from snowballing, the remaining
+        /// backlog is dropped.
+        int maxStepsPerIteration = 5;
+        /// If true, frames are only presented while a window is damaged, so an idle app sleeps until input arrives
+        /// or the next fixed step is due. If false, all windows are redrawn at targetFps.
+        bool renderOnlyWhenDirty = true;
+        /// Allocations the frame loop thread may make per iteration, on events, steps, update and redraw, before
+        /// the iteration is flagged in FrameStats::overBudget, and on stderr whenever it sets a new maximum. -1
+        /// disables the check. Allocations are only counted with TRACK_ALLOCATIONS.
+        int allocationBudget = -1;
+    };
+
+    /// Statistics of App::frameLoopRun, all times in milliseconds.
+    struct FrameStats {
+        uint64_t wakeups = 0; // loop iterations, one per poll wakeup
+        uint64_t frames = 0; // iterations that redrew at least one window
+        uint64_t fixedSteps = 0;
+        uint64_t droppedSteps = 0; // steps skipped because maxStepsPerIteration was hit
+
+        double lastWorkMs = 0; // time spent on events, steps, update and redraw in the last frame
+        double minWorkMs = std::numeric_limits<double>::max();
+        double maxWorkMs = 0;
+        double avgWorkMs = 0;
+        double avgFrameIntervalMs = 0; // average time between two frames
+
+        uint64_t allocations = 0; // by the frame loop thread during the work of all iterations
+        uint64_t lastAllocations = 0; // in the last iteration
+        uint64_t maxAllocations = 0; // in any one iteration
+        uint64_t overBudget = 0; // iterations that allocated more than FrameLoopConfig::allocationBudget
+
+        void recordFrame(const double workMs, const double intervalMs) noexcept {
+            frames++;
+            lastWorkMs = workMs;
+            minWorkMs = std::min(minWorkMs, workMs);
+            maxWorkMs = std::max(maxWorkMs, workMs);
+            avgWorkMs += (workMs - avgWorkMs) / static_cast<double>(frames);
+            if (frames > 1) avgFrameIntervalMs += (intervalMs - avgFrameIntervalMs) / static_cast<double>(frames - 1);
+        }
+
+        /// @return True if the iteration broke the budget with more allocations than any iteration before.
+        bool recordAllocations(const uint64_t count, const int budget) noexcept {
+            allocations += count;
+            lastAllocations = count;
+            const bool newMax = count > maxAllocations;
+            maxAllocations = std::max(maxAllocations, count);
+            if (budget < 0 || count <= static_cast<uint64_t>(budget)) return false;
+            overBudget++;
+            return newMax;
+        }
+    };
+}
+
+#endif //X11TEST_FRAMELOOP_H
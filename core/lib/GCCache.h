@@ -0,0 +1,146 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_GCCACHE_H
+#define X11TEST_GCCACHE_H
+#include <compare>
+#include <cstddef>
+#include <map>
+#include <ranges>
+#include <X11/Xlib.h>
+
+namespace X11App {
+    /// The subset of graphics context state the draw functions care about. Every distinct combination gets its own GC.
+    struct GCState {
+        unsigned long foreground = 0;
+        Font font = None; // None keeps the server default font
+        int lineWidth = 0; // 0 selects the fast "thin line" algorithm
+        int lineStyle = LineSolid;
+
+        auto operator<=>(const GCState &) const = default;
+    };
+
+    /// Counters to verify the cache is actually saving requests.
+    struct GCCacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t live = 0;
+    };
+
+    /**
+     * Lazily creates one GC per (window, GCState) and keeps it alive until the window is closed.
+     * Replaces the XCreateGC / XChangeGC / XFreeGC triple per primitive with a single map lookup.
+     */
+    class GCCache {
+        struct Key {
+            int winId;
+            GCState state;
+
+            auto operator<=>(const Key &) const = default;
+        };
+
+        struct Entry {
+            GC gc;
+            unsigned int clipGeneration = 0; // value of m_ClipGeneration the clip of gc matches
+        };
+
+        Display *m_Display;
+        std::map<Key, Entry> m_Cache{};
+        GCCacheStats m_Stats{};
+
+        // the clip is applied lazily to the GCs that are actually used while it is active
+        unsigned int m_ClipGeneration = 0;
+        bool m_HasClip = false;
+        XRectangle m_Clip{};
+
+        GC applyClip(Entry &entry) {
+            if (entry.clipGeneration == m_ClipGeneration) return entry.gc;
+
+            if (m_HasClip) XSetClipRectangles(m_Display, entry.gc, 0, 0, const_cast<XRectangle *>(&m_Clip), 1, YXBanded);
+            else XSetClipMask(m_Display, entry.gc, None);
+            entry.clipGeneration = m_ClipGeneration;
+            return entry.gc;
+        }
+
+    public:
+        explicit GCCache(Display *display) : m_Display(display) {
+        }
+
+        GCCache(const GCCache &) = delete;
+
+        GCCache &operator=(const GCCache &) = delete;
+
+        ~GCCache() { clear(); }
+
+        /// @param winId The ID of the window the GC belongs to. Used for invalidation only.
+        /// @param drawable Any drawable with the root and depth of the window, used to create the GC on a miss.
+        /// @param state The GC state to look up.
+        /// @return A GC with the requested state. Owned by the cache, do not free.
+        GC get(const int winId, const Drawable drawable, const GCState &state) {
+            const Key key{winId, state};
+            if (const auto it = m_Cache.find(key); it != m_Cache.end()) {
+                m_Stats.hits++;
+                return applyClip(it->second);
+            }
+
+            m_Stats.misses++;
+            XGCValues values{};
+            unsigned long mask = GCForeground | GCLineWidth | GCLineStyle | GCGraphicsExposures;
+            values.graphics_exposures = False; // nothing handles GraphicsExpose/NoExpose after XCopyArea
+            values.foreground = state.foreground;
+            values.line_width = state.lineWidth;
+            values.line_style = state.lineStyle;
+            if (state.font != None) {
+                values.font = state.font;
+                mask |= GCFont;
+            }
+
+            const GC gc = XCreateGC(m_Display, drawable, mask, &values);
+            Entry &entry = m_Cache.emplace(key, Entry{.gc = gc}).first->second;
+            m_Stats.live = m_Cache.size();
+            return applyClip(entry);
+        }
+
+        /// Restrict every GC handed out from now on to the given rectangle, until clearClip is called.
+        /// @param rect The clip rectangle in drawable coordinates.
+        void setClip(const XRectangle &rect) noexcept {
+            m_Clip = rect;
+            m_HasClip = true;
+            m_ClipGeneration++;
+        }
+
+        /// Remove the clip set with setClip from every GC handed out from now on.
+        void clearClip() noexcept {
+            if (!m_HasClip) return;
+            m_HasClip = false;
+            m_ClipGeneration++;
+        }
+
+        /// Free every GC belonging to the given window. Must be called before the window is destroyed.
+        /// @param winId The ID of the window whose GCs should be freed.
+        void invalidate(const int winId) {
+            for (auto it = m_Cache.begin(); it != m_Cache.end();) {
+                if (it->first.winId == winId) {
+                    XFreeGC(m_Display, it->second.gc);
+                    it = m_Cache.erase(it);
+                } else ++it;
+            }
+            m_Stats.live = m_Cache.size();
+        }
+
+        /// Free every cached GC. Must be called before the display is closed.
+        void clear() {
+            if (!m_Display) return;
+            for (const Entry &entry: m_Cache | std::views::values) XFreeGC(m_Display, entry.gc);
+            m_Cache.clear();
+            m_Stats.live = 0;
+        }
+
+        [[nodiscard]] const GCCacheStats &stats() const noexcept { return m_Stats; }
+
+        void resetStats() noexcept { m_Stats = {.hits = 0, .misses = 0, .live = m_Cache.size()}; }
+    };
+}
+
+#endif //X11TEST_GCCACHE_H
@@ -0,0 +1,50 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_INPUTQUEUE_H
+#define X11TEST_INPUTQUEUE_H
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <X11/Xlib.h>
+
+#include "SpscRing.h"
+
+namespace X11App {
+    /// An event as read by the input thread, stamped with the time it was taken off the connection.
+    struct QueuedEvent {
+        XEvent event;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    /// Queue between the input thread and the main loop. 256 events of ~200 bytes each.
+    using InputQueue = SpscRing<QueuedEvent, 256>;
+
+    /// Metrics of the threaded input mode, ages in microseconds.
+    struct InputQueueStats {
+        uint64_t events = 0; // events handled by the main loop
+        uint64_t batches = 0; // calls to handleAllQueuedEvents that handled at least one event
+        uint64_t fullStalls = 0; // times the input thread had to wait because the queue was full
+        size_t depth = 0; // queue depth at the start of the last batch
+        size_t maxDepth = 0;
+        double lastAgeUs = 0; // time between reading the event and handling it
+        double maxAgeUs = 0;
+        double avgAgeUs = 0;
+
+        void recordBatch(const size_t queued) noexcept {
+            batches++;
+            depth = queued;
+            maxDepth = std::max(maxDepth, queued);
+        }
+
+        void recordEvent(const double ageUs) noexcept {
+            events++;
+            lastAgeUs = ageUs;
+            maxAgeUs = std::max(maxAgeUs, ageUs);
+            avgAgeUs += (ageUs - avgAgeUs) / static_cast<double>(events);
+        }
+    };
+}
+
+#endif //X11TEST_INPUTQUEUE_H
@@ -4,41 +4,111 @@
 
 #ifndef X11TEST_KEYSTATEMANAGER_H
 #define X11TEST_KEYSTATEMANAGER_H
+#include <array>
+#include <bitset>
 #include <unordered_map>
 #include <X11/X.h>
+#include <X11/Xlib.h>
 
 
+/**
+ * Keyboard state as dense bitsets indexed by keycode, which X11 limits to 8-255. Key events only flip a bit, and
+ * queries by KeySym go through lookup tables built from the keyboard mapping, so neither allocates. The tables
+ * map column 0 of the mapping, the unshifted KeySym, like XLookupKeysym(event, 0) did.
+ *
+ * Pressed and released edges are computed once per frame by frameAdvance, so every query in a frame sees the same
+ * answer however often it is asked.
+ */
 class KeyStateManager {
-    std::unordered_map<KeySym, bool> pressedKeys{};
-    std::unordered_map<KeySym, bool> prevState{};
+public:
+    static constexpr size_t keycodeCount = 256;
+    using Keys = std::bitset<keycodeCount>;
+
+private:
+    Keys m_Down{}; // updated by every key event
+    Keys m_Previous{}; // m_Down at the last frameAdvance
+    Keys m_Pressed{}, m_Released{}; // edges between the last two frameAdvance calls
+    // KeySym -> keycodes producing it. Latin-1 (0x0000-0x00ff) and the function keys (0xff00-0xffff) are dense,
+    // everything else, e.g. media keys, lives in the map.
+    std::array<Keys, 512> m_Dense{};
+    std::unordered_map<KeySym, Keys> m_Sparse{};
+
+    static constexpr size_t denseIndex(const KeySym key) noexcept {
+        if (key < 0x100) return key;
+        if ((key & ~KeySym{0xff}) == 0xff00) return 0x100 + (key & 0xff);
+        return ~size_t{0};
+    }
+
+    /// @return The keycodes producing the KeySym, or nullptr if none does.
+    [[nodiscard]] const Keys *keycodes(const KeySym key) const noexcept {
+        if (const size_t index = denseIndex(key); index != ~size_t{0}) return &m_Dense[index];
+        const auto it = m_Sparse.find(key);
+        return it != m_Sparse.end() ? &it->second : nullptr;
+    }
 
 public:
-    void reserve(const size_t size) { pressedKeys.reserve(size); prevState.reserve(size); }
+    KeyStateManager() = default;
 
-    /// @param key The KeySym to mark as pressed.
-    void setKeyPressed(const KeySym key) { pressedKeys[key] = true; }
+    explicit KeyStateManager(Display *display) { mappingLoad(display); }
 
-    /// @param key The KeySym to mark as released.
-    void setKeyReleased(const KeySym key) { pressedKeys[key] = false; }
+    /// Rebuild the KeySym tables from the server's keyboard mapping. Call it once at startup and again on every
+    /// MappingNotify for the keyboard, after XRefreshKeyboardMapping. Key states are kept, they are per keycode.
+    void mappingLoad(Display *display) {
+        int minKeycode = 0, maxKeycode = 0, keysymsPerKeycode = 0;
+        XDisplayKeycodes(display, &minKeycode, &maxKeycode);
+        KeySym *mapping = XGetKeyboardMapping(display, static_cast<KeyCode>(minKeycode), maxKeycode - minKeycode + 1,
+                                              &keysymsPerKeycode);
+        m_Dense.fill({});
+        m_Sparse.clear();
+        if (mapping == nullptr) return;
+
+        for (int keycode = minKeycode; keycode <= maxKeycode; ++keycode) {
+            const KeySym key = mapping[(keycode - minKeycode) * keysymsPerKeycode];
+            if (key == NoSymbol) continue;
+            if (const size_t index = denseIndex(key); index != ~size_t{0}) m_Dense[index].set(keycode);
+            else m_Sparse[key].set(keycode);
+        }
+        XFree(mapping);
+    }
+
+    /// @param keycode The keycode of the key that went down.
+    void setKeyPressed(const unsigned keycode) noexcept { m_Down.set(keycode % keycodeCount); }
+
+    /// @param keycode The keycode of the key that went up.
+    void setKeyReleased(const unsigned keycode) noexcept { m_Down.reset(keycode % keycodeCount); }
+
+    /// Start a new frame: the keys whose state differs from the last frame are its edges.
+    void frameAdvance() noexcept {
+        const Keys changed = m_Down ^ m_Previous;
+        m_Pressed = changed & m_Down;
+        m_Released = changed & m_Previous;
+        m_Previous = m_Down;
+    }
 
     /// @param key The KeySym to check.
-    /// @return True if the key is currently held down, false otherwise.
-    bool isKeyDown(const KeySym key) const { return pressedKeys.contains(key) && pressedKeys.at(key); }
+    /// @return True if a key producing it is currently held down, false otherwise.
+    [[nodiscard]] bool isKeyDown(const KeySym key) const noexcept {
+        const Keys *codes = keycodes(key);
+        return codes != nullptr && (*codes & m_Down).any();
+    }
 
     /// @param key The KeySym to check.
-    /// @return True if the key was just pressed (transitioned from up to down), false otherwise.
-    bool isKeyPressed(const KeySym key) {
-        const bool currentlyDown = isKeyDown(key);
-        const bool wasDown = prevState.contains(key) && prevState.at(key);
-        prevState[key] = currentlyDown;
-        return currentlyDown && !wasDown;
+    /// @return True if a key producing it went down since the frame before, false otherwise.
+    [[nodiscard]] bool isKeyPressed(const KeySym key) const noexcept {
+        const Keys *codes = keycodes(key);
+        return codes != nullptr && (*codes & m_Pressed).any();
     }
 
-    /// @return True if the current state and the previous state differ, false otherwise.
-    bool stateChanged() const {
-        return pressedKeys != prevState;
+    /// @param key The KeySym to check.
+    /// @return True if a key producing it went up since the frame before, false otherwise.
+    [[nodiscard]] bool isKeyReleased(const KeySym key) const noexcept {
+        const Keys *codes = keycodes(key);
+        return codes != nullptr && (*codes & m_Released).any();
     }
+
+    /// @return True if any key went down or up since the frame before, false otherwise.
+    [[nodiscard]] bool stateChanged() const noexcept { return (m_Pressed | m_Released).any(); }
 };
 
 
-#endif //X11TEST_KEYSTATEMANAGER_H
\ No newline at end of file
+#endif //X11TEST_KEYSTATEMANAGER_H
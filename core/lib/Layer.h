@@ -0,0 +1,32 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_LAYER_H
+#define X11TEST_LAYER_H
+#include <functional>
+
+#include <X11/Xlib.h>
+
+namespace X11App {
+    /// Draws the content of a layer with the App's draw functions, given the size of the window in pixels.
+    using LayerRender = std::function<void(int winId, unsigned int width, unsigned int height)>;
+
+    /**
+     * Static content of a window, e.g. grid lines, backgrounds or HUD frames, rendered once into a server side
+     * Pixmap. Clearing the window, or its back buffer, copies the Pixmap instead of filling the background color,
+     * so the content costs no requests per frame until the window size changes or it is invalidated.
+     */
+    struct Layer {
+        Pixmap pixmap = None;
+        LayerRender render{};
+        bool asBackground = false; // install the Pixmap as the window background while single buffered
+        bool installed = false; // it is the window background right now, the server repaints it on XClearArea
+        bool stale = true; // render again before the next redraw
+        bool ownsStructureMask = false; // StructureNotifyMask was only selected to track resizes
+        unsigned int width = 0;
+        unsigned int height = 0;
+    };
+}
+
+#endif //X11TEST_LAYER_H
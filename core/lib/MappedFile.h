@@ -0,0 +1,89 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_MAPPEDFILE_H
+#define X11TEST_MAPPEDFILE_H
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace X11App {
+    /**
+     * Read-only memory mapping of a whole file. Pages are read in by the kernel as they are touched, so large files
+     * can be parsed front to back without ever being copied into a buffer.
+     */
+    class MappedFile {
+        const char *m_Data = nullptr;
+        size_t m_Size = 0;
+
+    public:
+        MappedFile() = default;
+
+        /// @throws std::runtime_error if the file cannot be opened or mapped.
+        explicit MappedFile(const std::string &path) {
+            const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+
+            struct stat info{};
+            if (fstat(fd, &info) != 0) {
+                const int error = errno;
+                close(fd);
+                throw std::runtime_error("Failed to stat " + path + ": " + std::strerror(error));
+            }
+            m_Size = static_cast<size_t>(info.st_size);
+
+            // mapping 0 bytes fails, an empty file is just an empty view
+            if (m_Size != 0) {
+                void *data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED) {
+                    const int error = errno;
+                    close(fd);
+                    throw std::runtime_error("Failed to map " + path + ": " + std::strerror(error));
+                }
+                // read ahead aggressively, the file is parsed front to back
+                madvise(data, m_Size, MADV_SEQUENTIAL);
+                m_Data = static_cast<const char *>(data);
+            }
+            // the mapping keeps the file alive
+            close(fd);
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        MappedFile(MappedFile &&other) noexcept
+            : m_Data(std::exchange(other.m_Data, nullptr)), m_Size(std::exchange(other.m_Size, 0)) {
+        }
+
+        MappedFile &operator=(MappedFile &&other) noexcept {
+            if (this != &other) {
+                unmap();
+                m_Data = std::exchange(other.m_Data, nullptr);
+                m_Size = std::exchange(other.m_Size, 0);
+            }
+            return *this;
+        }
+
+        ~MappedFile() { unmap(); }
+
+        void unmap() noexcept {
+            if (m_Data != nullptr) munmap(const_cast<char *>(m_Data), m_Size);
+            m_Data = nullptr;
+            m_Size = 0;
+        }
+
+        [[nodiscard]] const char *data() const noexcept { return m_Data; }
+        [[nodiscard]] size_t size() const noexcept { return m_Size; }
+        [[nodiscard]] std::string_view view() const noexcept { return {m_Data, m_Size}; }
+    };
+}
+
+#endif //X11TEST_MAPPEDFILE_H
@@ -0,0 +1,319 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_PROFILER_H
+#define X11TEST_PROFILER_H
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "SpscRing.h"
+
+namespace X11App {
+    /// One finished zone. name must be a string with static storage duration, e.g. a literal.
+    struct ProfileEvent {
+        const char *name;
+        uint64_t begin, end; // ticks of profileTicks
+        uint32_t depth; // zones open on the thread when this one began
+    };
+
+    /// @return A timestamp in ticks: the TSC on x86 (assumed invariant and synchronised across cores, as on any
+    /// CPU of the last decade), steady_clock nanoseconds elsewhere. Profiler converts ticks to time.
+    inline uint64_t profileTicks() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /// Statistics of one zone over the last Profiler::frameWindow frames it ran in, per frame.
+    struct ZoneSummary {
+        std::string name;
+        uint32_t depth = 0; // shallowest nesting it was seen at
+        size_t frames = 0; // frames of the window the zone ran in
+        double callsPerFrame = 0;
+        double minMs = 0, avgMs = 0, p99Ms = 0; // of the zone's total time per frame
+    };
+
+    /**
+     * Low-overhead zone profiler. Use it through the PROFILE_* macros, which compile to nothing unless PROFILING
+     * is set, so instrumented code costs nothing in builds without it.
+     *
+     * Every thread records finished zones into its own lock-free SpscRing, which costs two timestamps and a push
+     * per zone and never blocks; zones are dropped if the ring is full. One consumer thread, normally the one
+     * running the frame loop, drains all rings once per frame with frameEnd, aggregates the time per zone and
+     * frame, and keeps the raw events while a trace is recorded, for export in the Chrome trace event format
+     * (chrome://tracing, Perfetto).
+     *
+     * Everything but the zones themselves and threadName must be called from the consumer thread.
+     */
+    class Profiler {
+    public:
+        static constexpr size_t ringCapacity = 1 << 14; // events per thread between two frameEnd calls
+        static constexpr size_t frameWindow = 240; // frames the per-zone statistics cover
+        static constexpr size_t maxTraceEvents = 1 << 21; // events a trace keeps, 40 bytes with the thread id, ~80 MiB
+
+        struct Thread {
+            SpscRing<ProfileEvent, ringCapacity> ring{};
+            uint32_t depth = 0; // owner only
+            uint32_t id = 0;
+            std::string name{}; // guarded by Profiler::m_Mutex
+            std::atomic<uint64_t> dropped{0};
+        };
+
+    private:
+        struct Zone {
+            std::string name;
+            uint32_t depth = ~0u;
+            uint64_t frameTicks = 0, frameCalls = 0; // of the frame being collected
+            std::vector<double> history{}; // ms per frame, ring of frameWindow
+            std::vector<uint64_t> calls{}; // calls per frame, parallel to history
+            size_t next = 0;
+        };
+
+        mutable std::mutex m_Mutex{}; // guards m_Threads and thread names
+        std::vector<std::unique_ptr<Thread>> m_Threads{};
+        std::unordered_map<std::string_view, Zone> m_Zones{};
+        std::vector<std::pair<ProfileEvent, uint32_t>> m_Trace{}; // event, thread id
+        bool m_Tracing = false;
+        uint64_t m_TraceDropped = 0;
+        const uint64_t m_StartTicks = profileTicks();
+        const std::chrono::steady_clock::time_point m_StartTime = std::chrono::steady_clock::now();
+        double m_NsPerTick = 1;
+
+        static inline thread_local Thread *t_Thread = nullptr;
+
+        Profiler() = default;
+
+        /// Refine the tick rate against steady_clock over everything since the profiler started.
+        void calibrate() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            const uint64_t ticks = profileTicks() - m_StartTicks;
+            const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - m_StartTime;
+            if (ticks > 0 && elapsed.count() > 0) m_NsPerTick = elapsed.count() / static_cast<double>(ticks);
+#endif
+        }
+
+        /// Move every recorded event into the zone totals of the current frame, and into the trace if recording.
+        void drain() {
+            std::lock_guard lock(m_Mutex);
+            for (const auto &thread: m_Threads) {
+                ProfileEvent event{};
+                while (thread->ring.tryPop(event)) {
+                    Zone &zone = m_Zones[event.name];
+                    if (zone.name.empty()) zone.name = event.name;
+                    zone.depth = std::min(zone.depth, event.depth);
+                    zone.frameTicks += event.end - event.begin;
+                    zone.frameCalls++;
+                    if (!m_Tracing) continue;
+                    if (m_Trace.size() < maxTraceEvents) m_Trace.emplace_back(event, thread->id);
+                    else m_TraceDropped++;
+                }
+            }
+        }
+
+    public:
+        Profiler(const Profiler &) = delete;
+        Profiler &operator=(const Profiler &) = delete;
+
+        static Profiler &instance() {
+            static Profiler profiler;
+            return profiler;
+        }
+
+        /// @return The recording state of the calling thread, registered on first use.
+        static Thread &thread() {
+            if (t_Thread != nullptr) return *t_Thread;
+            Profiler &profiler = instance();
+            std::lock_guard lock(profiler.m_Mutex);
+            auto &thread = profiler.m_Threads.emplace_back(std::make_unique<Thread>());
+            thread->id = static_cast<uint32_t>(profiler.m_Threads.size());
+            thread->name = "thread " + std::to_string(thread->id);
+            return *(t_Thread = thread.get());
+        }
+
+        /// Name the calling thread in traces. May be called from any thread.
+        static void threadName(std::string name) {
+            Thread &current = thread();
+            std::lock_guard lock(instance().m_Mutex);
+            current.name = std::move(name);
+        }
+
+        /// Close the current frame: drain all threads and add the time of every zone that ran to its statistics.
+        void frameEnd() {
+            drain();
+            calibrate();
+            for (Zone &zone: m_Zones | std::views::values) {
+                if (zone.frameCalls == 0) continue;
+                const double ms = static_cast<double>(zone.frameTicks) * m_NsPerTick / 1e6;
+                if (zone.history.size() < frameWindow) {
+                    zone.history.push_back(ms);
+                    zone.calls.push_back(zone.frameCalls);
+                } else {
+                    zone.history[zone.next] = ms;
+                    zone.calls[zone.next] = zone.frameCalls;
+                }
+                zone.next = (zone.next + 1) % frameWindow;
+                zone.frameTicks = zone.frameCalls = 0;
+            }
+        }
+
+        /// @return Per-frame statistics of every zone seen, shallowest first, then by average time.
+        [[nodiscard]] std::vector<ZoneSummary> summary() const {
+            std::vector<ZoneSummary> out;
+            for (const Zone &zone: m_Zones | std::views::values) {
+                if (zone.history.empty()) continue;
+                std::vector<double> sorted = zone.history;
+                std::ranges::sort(sorted);
+                double total = 0;
+                for (const double ms: sorted) total += ms;
+                uint64_t calls = 0;
+                for (const uint64_t count: zone.calls) calls += count;
+                const size_t p99 = std::min(sorted.size() - 1, (sorted.size() * 99 + 99) / 100 - 1);
+                out.push_back({
+                    zone.name, zone.depth, sorted.size(),
+                    static_cast<double>(calls) / static_cast<double>(sorted.size()), sorted.front(),
+                    total / static_cast<double>(sorted.size()), sorted[p99]
+                });
+            }
+            std::ranges::sort(out, [](const ZoneSummary &a, const ZoneSummary &b) {
+                return a.depth != b.depth ? a.depth < b.depth : a.avgMs > b.avgMs;
+            });
+            return out;
+        }
+
+        /// Write the summary as a table, indented by nesting depth.
+        void report(std::ostream &out) const {
+            out << "zone                            frames  calls/frame   min ms   avg ms   p99 ms\n";
+            for (const ZoneSummary &zone: summary()) {
+                std::string name(2 * zone.depth, ' ');
+                name += zone.name;
+                name.resize(std::max<size_t>(name.size(), 32), ' ');
+                char line[96];
+                std::snprintf(line, sizeof(line), "%6zu %12.1f %8.3f %8.3f %8.3f\n", zone.frames, zone.callsPerFrame,
+                              zone.minMs, zone.avgMs, zone.p99Ms);
+                out << name << line;
+            }
+            uint64_t dropped = 0;
+            {
+                std::lock_guard lock(m_Mutex);
+                for (const auto &thread: m_Threads) dropped += thread->dropped.load(std::memory_order_relaxed);
+            }
+            if (dropped > 0) out << dropped << " zones dropped, call frameEnd more often\n";
+        }
+
+        /// Start keeping the raw events of every zone finished from now on, dropping a previous trace.
+        void traceStart() {
+            drain();
+            m_Trace.clear();
+            m_TraceDropped = 0;
+            m_Tracing = true;
+        }
+
+        [[nodiscard]] bool tracing() const noexcept { return m_Tracing; }
+
+        /**
+         * Stop recording and write the trace in the Chrome trace event format, one complete ("X") event per zone
+         * with timestamps in microseconds since the profiler started.
+         * @return The number of events written.
+         * @throws std::runtime_error if the file cannot be written.
+         */
+        size_t traceWrite(const std::string &path) {
+            drain();
+            calibrate();
+            m_Tracing = false;
+
+            std::ofstream out(path);
+            out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+            {
+                std::lock_guard lock(m_Mutex);
+                for (const auto &thread: m_Threads) {
+                    out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id
+                            << ", \"args\": {\"name\": \"" << thread->name << "\"}},\n";
+                }
+            }
+            const auto micros = [this](const uint64_t ticks) {
+                return static_cast<double>(ticks) * m_NsPerTick / 1e3;
+            };
+            char line[256];
+            for (size_t i = 0; i < m_Trace.size(); ++i) {
+                const auto &[event, tid] = m_Trace[i];
+                // zone names are identifiers written in the source, they need no escaping
+                std::snprintf(line, sizeof(line), "{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+                              "\"ts\": %.3f, \"dur\": %.3f}%s\n", event.name, tid, micros(event.begin - m_StartTicks),
+                              micros(event.end - event.begin), i + 1 < m_Trace.size() ? "," : "");
+                out << line;
+            }
+            out << "]}\n";
+            if (!out) throw std::runtime_error("Could not write trace " + path);
+
+            const size_t written = m_Trace.size();
+            m_Trace.clear();
+            m_Trace.shrink_to_fit();
+            return written;
+        }
+
+        /// @return Events the current or last trace could not keep because it was full.
+        [[nodiscard]] uint64_t traceDropped() const noexcept { return m_TraceDropped; }
+    };
+
+    /// Records the time from construction to destruction as a zone of the calling thread.
+    class ProfileZone {
+        Profiler::Thread &m_Thread;
+        const char *m_Name;
+        uint32_t m_Depth;
+        uint64_t m_Begin;
+
+    public:
+        explicit ProfileZone(const char *name)
+            : m_Thread(Profiler::thread()), m_Name(name), m_Depth(m_Thread.depth++), m_Begin(profileTicks()) {
+        }
+
+        ProfileZone(const ProfileZone &) = delete;
+        ProfileZone &operator=(const ProfileZone &) = delete;
+
+        ~ProfileZone() {
+            const uint64_t end = profileTicks();
+            m_Thread.depth--;
+            if (!m_Thread.ring.tryPush({m_Name, m_Begin, end, m_Depth}))
+                m_Thread.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILING
+/// Profile the rest of the enclosing scope as a zone with the given name, a string literal.
+#define PROFILE_ZONE(NAME) const X11App::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(NAME)
+/// Name the calling thread in traces.
+#define PROFILE_THREAD(NAME) X11App::Profiler::threadName(NAME)
+/// Close the frame, from the thread running the frame loop.
+#define PROFILE_FRAME() X11App::Profiler::instance().frameEnd()
+#else
+#define PROFILE_ZONE(NAME) static_cast<void>(0)
+#define PROFILE_THREAD(NAME) static_cast<void>(0)
+#define PROFILE_FRAME() static_cast<void>(0)
+#endif
+
+#endif //X11TEST_PROFILER_H
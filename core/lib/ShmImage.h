@@ -0,0 +1,178 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_SHMIMAGE_H
+#define X11TEST_SHMIMAGE_H
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <stdexcept>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+
+namespace X11App {
+    /// Writable view of a ShmImage. Row y starts at pixels[y * stride].
+    struct ImageView {
+        std::span<uint32_t> pixels;
+        size_t stride = 0; // in pixels, may be larger than width
+        unsigned int width = 0;
+        unsigned int height = 0;
+
+        uint32_t &at(const unsigned int x, const unsigned int y) const { return pixels[y * stride + x]; }
+    };
+
+    /**
+     * 32 bit client side image that is uploaded with XShmPutImage when the MIT-SHM extension is usable, or with a
+     * plain XPutImage otherwise (e.g. remote displays). With MIT-SHM the pixels live in a segment shared with the
+     * server, so presenting does not serialize the pixel data through the socket. The segment must not be written
+     * while a put is in flight, which is tracked with the ShmCompletion event.
+     */
+    class ShmImage {
+        Display *m_Display;
+        XImage *m_Image = nullptr;
+        XShmSegmentInfo m_ShmInfo{};
+        bool m_UsesShm = false;
+        bool m_Pending = false;
+        int m_RedShift, m_GreenShift, m_BlueShift;
+
+        static inline bool s_AttachFailed = false;
+
+        static int attachErrorHandler(Display *, XErrorEvent *) {
+            s_AttachFailed = true;
+            return 0;
+        }
+
+        bool tryCreateShm(Visual *visual, const int depth, const unsigned int width, const unsigned int height) {
+            if (!XShmQueryExtension(m_Display)) return false;
+
+            m_Image = XShmCreateImage(m_Display, visual, depth, ZPixmap, nullptr, &m_ShmInfo, width, height);
+            if (!m_Image) return false;
+
+            m_ShmInfo.shmid = shmget(IPC_PRIVATE, static_cast<size_t>(m_Image->bytes_per_line) * height,
+                                     IPC_CREAT | 0600);
+            if (m_ShmInfo.shmid < 0) return destroyPartialShm();
+
+            m_ShmInfo.shmaddr = m_Image->data = static_cast<char *>(shmat(m_ShmInfo.shmid, nullptr, 0));
+            if (m_ShmInfo.shmaddr == reinterpret_cast<char *>(-1)) {
+                m_ShmInfo.shmaddr = nullptr;
+                shmctl(m_ShmInfo.shmid, IPC_RMID, nullptr);
+                return destroyPartialShm();
+            }
+            m_ShmInfo.readOnly = False;
+
+            // attaching fails asynchronously with BadAccess if the server cannot see our segment (remote display)
+            s_AttachFailed = false;
+            XSync(m_Display, False);
+            const auto previousHandler = XSetErrorHandler(attachErrorHandler);
+            XShmAttach(m_Display, &m_ShmInfo);
+            XSync(m_Display, False);
+            XSetErrorHandler(previousHandler);
+
+            // the segment is freed as soon as both sides detached
+            shmctl(m_ShmInfo.shmid, IPC_RMID, nullptr);
+
+            if (s_AttachFailed) {
+                shmdt(m_ShmInfo.shmaddr);
+                m_ShmInfo.shmaddr = nullptr;
+                return destroyPartialShm();
+            }
+            return true;
+        }
+
+        bool destroyPartialShm() {
+            XDestroyImage(m_Image);
+            m_Image = nullptr;
+            return false;
+        }
+
+        void createPlain(Visual *visual, const int depth, const unsigned int width, const unsigned int height) {
+            m_Image = XCreateImage(m_Display, visual, depth, ZPixmap, 0, nullptr, width, height, 32, 0);
+            if (!m_Image) throw std::runtime_error("Failed to create image");
+
+            // XDestroyImage frees the data with free()
+            m_Image->data = static_cast<char *>(std::calloc(static_cast<size_t>(m_Image->bytes_per_line), height));
+            if (!m_Image->data) {
+                XDestroyImage(m_Image);
+                throw std::bad_alloc();
+            }
+        }
+
+    public:
+        /// @param display The display connection.
+        /// @param visual The visual of the windows the image will be put on. Must be a 32 bits per pixel TrueColor visual.
+        /// @param depth The depth of the windows the image will be put on.
+        /// @param width The width of the image in pixels.
+        /// @param height The height of the image in pixels.
+        /// @param tryShm If false, always use the XPutImage path.
+        /// @throws std::runtime_error if the image cannot be created or the visual is not 32 bits per pixel.
+        ShmImage(Display *display, Visual *visual, const int depth, const unsigned int width,
+                 const unsigned int height, const bool tryShm = true)
+            : m_Display(display), m_RedShift(std::countr_zero(visual->red_mask)),
+              m_GreenShift(std::countr_zero(visual->green_mask)), m_BlueShift(std::countr_zero(visual->blue_mask)) {
+            m_UsesShm = tryShm && tryCreateShm(visual, depth, width, height);
+            if (!m_UsesShm) createPlain(visual, depth, width, height);
+
+            if (m_Image->bits_per_pixel != 32) {
+                release();
+                throw std::runtime_error("Only 32 bits per pixel images are supported");
+            }
+        }
+
+        ShmImage(const ShmImage &) = delete;
+
+        ShmImage &operator=(const ShmImage &) = delete;
+
+        ~ShmImage() { release(); }
+
+        /// Free the image and detach the shared segment. Must be called before the display is closed.
+        void release() noexcept {
+            if (!m_Image) return;
+            if (m_UsesShm) {
+                XShmDetach(m_Display, &m_ShmInfo);
+                XDestroyImage(m_Image); // does not touch the shared data
+                shmdt(m_ShmInfo.shmaddr);
+            } else XDestroyImage(m_Image);
+            m_Image = nullptr;
+        }
+
+        [[nodiscard]] bool usesShm() const noexcept { return m_UsesShm; }
+        [[nodiscard]] bool pending() const noexcept { return m_Pending; }
+        [[nodiscard]] unsigned int width() const noexcept { return m_Image->width; }
+        [[nodiscard]] unsigned int height() const noexcept { return m_Image->height; }
+        [[nodiscard]] ShmSeg segment() const noexcept { return m_ShmInfo.shmseg; }
+
+        /// @return A writable view of the pixels. Must not be written while pending() is true.
+        [[nodiscard]] ImageView view() const noexcept {
+            const size_t stride = static_cast<size_t>(m_Image->bytes_per_line) / 4;
+            return {
+                .pixels = {reinterpret_cast<uint32_t *>(m_Image->data), stride * m_Image->height}, .stride = stride,
+                .width = static_cast<unsigned int>(m_Image->width), .height = static_cast<unsigned int>(m_Image->height)
+            };
+        }
+
+        /// Pack 8 bit color components into a pixel value for this image's visual.
+        [[nodiscard]] uint32_t pack(const uint8_t red, const uint8_t green, const uint8_t blue) const noexcept {
+            return static_cast<uint32_t>(red) << m_RedShift | static_cast<uint32_t>(green) << m_GreenShift |
+                   static_cast<uint32_t>(blue) << m_BlueShift;
+        }
+
+        /// Upload the image to the drawable. With MIT-SHM the call returns immediately and the image stays
+        /// pending until the ShmCompletion event for it arrives.
+        void put(const Drawable drawable, const GC gc, const int x, const int y) {
+            if (m_UsesShm) {
+                XShmPutImage(m_Display, drawable, gc, m_Image, 0, 0, x, y, m_Image->width, m_Image->height, True);
+                m_Pending = true;
+            } else XPutImage(m_Display, drawable, gc, m_Image, 0, 0, x, y, m_Image->width, m_Image->height);
+        }
+
+        /// Mark the last put as finished, call when the matching ShmCompletion event arrives.
+        void complete() noexcept { m_Pending = false; }
+    };
+}
+
+#endif //X11TEST_SHMIMAGE_H
@@ -0,0 +1,70 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_SPSCRING_H
+#define X11TEST_SPSCRING_H
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+namespace X11App {
+    /**
+     * Bounded lock-free ring buffer for exactly one producer and one consumer thread.
+     * The producer only writes m_Tail and the consumer only writes m_Head, each on its own cache line,
+     * and both keep a cached copy of the other index so the shared line is only read when the ring looks full/empty.
+     * @tparam T The element type, copied in and out.
+     * @tparam Capacity Number of slots, must be a power of two.
+     */
+    template<typename T, size_t Capacity>
+    class SpscRing {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+        static constexpr size_t mask = Capacity - 1;
+        static constexpr size_t cacheLine = 64;
+
+        alignas(cacheLine) std::atomic<size_t> m_Head{0}; // next slot to read, written by the consumer
+        size_t m_CachedTail = 0; // consumer's copy of m_Tail
+        alignas(cacheLine) std::atomic<size_t> m_Tail{0}; // next slot to write, written by the producer
+        size_t m_CachedHead = 0; // producer's copy of m_Head
+        alignas(cacheLine) std::array<T, Capacity> m_Slots{};
+
+    public:
+        /// Producer only.
+        /// @return False if the ring is full.
+        bool tryPush(const T &value) noexcept {
+            const size_t tail = m_Tail.load(std::memory_order_relaxed);
+            if (tail - m_CachedHead == Capacity) {
+                m_CachedHead = m_Head.load(std::memory_order_acquire);
+                if (tail - m_CachedHead == Capacity) return false;
+            }
+            m_Slots[tail & mask] = value;
+            m_Tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Consumer only.
+        /// @return False if the ring is empty.
+        bool tryPop(T &out) noexcept {
+            const size_t head = m_Head.load(std::memory_order_relaxed);
+            if (head == m_CachedTail) {
+                m_CachedTail = m_Tail.load(std::memory_order_acquire);
+                if (head == m_CachedTail) return false;
+            }
+            out = m_Slots[head & mask];
+            m_Head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Approximate number of queued elements, exact when called from either side while the other is idle.
+        [[nodiscard]] size_t size() const noexcept {
+            return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+        [[nodiscard]] static constexpr size_t capacity() noexcept { return Capacity; }
+    };
+}
+
+#endif //X11TEST_SPSCRING_H
@@ -0,0 +1,54 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_TRIPLEBUFFER_H
+#define X11TEST_TRIPLEBUFFER_H
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace X11App {
+    /**
+     * Lock-free triple buffer for one producer and one consumer thread that only care about the newest value.
+     *
+     * The producer fills back() and publishes it, the consumer calls update() and reads front(). The third slot sits
+     * in between and is swapped atomically with either side, so neither ever waits for the other or sees a slot
+     * that is being written. Values published while the consumer is not looking are overwritten, not queued.
+     * @tparam T The slot type. Slots are reused, so the producer should overwrite every field it relies on.
+     */
+    template<typename T>
+    class TripleBuffer {
+        static constexpr uint8_t indexMask = 3;
+        static constexpr uint8_t freshBit = 4; // the middle slot was published and not yet taken
+
+        std::array<T, 3> m_Slots{};
+        std::atomic<uint8_t> m_Middle{1};
+        uint8_t m_Back = 0; // producer only
+        uint8_t m_Front = 2; // consumer only
+
+    public:
+        /// Producer only.
+        /// @return The slot to fill before calling publish.
+        T &back() noexcept { return m_Slots[m_Back]; }
+
+        /// Producer only. Hand back() to the consumer and continue with a slot it does not read.
+        void publish() noexcept {
+            m_Back = m_Middle.exchange(static_cast<uint8_t>(m_Back | freshBit), std::memory_order_acq_rel) & indexMask;
+        }
+
+        /// Consumer only. Take the newest published slot, if there is one.
+        /// @return True if front() changed.
+        bool update() noexcept {
+            if (!(m_Middle.load(std::memory_order_relaxed) & freshBit)) return false;
+            m_Front = m_Middle.exchange(m_Front, std::memory_order_acq_rel) & indexMask;
+            return true;
+        }
+
+        /// Consumer only.
+        /// @return The slot taken by the last successful update.
+        [[nodiscard]] const T &front() const noexcept { return m_Slots[m_Front]; }
+    };
+}
+
+#endif //X11TEST_TRIPLEBUFFER_H
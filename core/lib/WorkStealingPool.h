@@ -0,0 +1,166 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_WORKSTEALINGPOOL_H
+#define X11TEST_WORKSTEALINGPOOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace X11App {
+    /// Counters of a WorkStealingPool.
+    struct WorkStealingPoolStats {
+        uint64_t batches = 0; // parallelFor calls that ran on more than one worker
+        uint64_t tasks = 0;
+        uint64_t steals = 0; // tasks run by a worker other than the one they were queued on
+    };
+
+    /**
+     * Fixed size thread pool for fork/join loops.
+     *
+     * parallelFor hands every worker a contiguous block of indices in its own queue, so neighbouring tasks tend to
+     * run on the same core. A worker takes tasks from the front of its own queue and, once that is empty, steals
+     * from the back of the other queues, which keeps all cores busy when tasks differ in cost.
+     * The calling thread works as worker 0, so a pool of size n starts n - 1 threads.
+     */
+    class WorkStealingPool {
+        struct alignas(64) Queue {
+            std::mutex mutex;
+            std::deque<size_t> tasks;
+        };
+
+        size_t m_Size;
+        std::unique_ptr<Queue[]> m_Queues;
+        std::vector<std::thread> m_Threads{};
+
+        std::mutex m_WakeMutex{};
+        std::condition_variable m_Wake{};
+        uint64_t m_Batch = 0; // incremented for every batch, guarded by m_WakeMutex
+        bool m_Stop = false;
+
+        // the running batch, written before its tasks are queued
+        void (*m_Invoke)(void *context, size_t index) = nullptr;
+        void *m_Context = nullptr;
+        std::atomic<size_t> m_Remaining{0};
+
+        std::atomic<uint64_t> m_Tasks{0}, m_Steals{0};
+        uint64_t m_Batches = 0;
+
+        bool pop(const size_t worker, size_t &task) {
+            {
+                Queue &own = m_Queues[worker];
+                std::lock_guard lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    task = own.tasks.front();
+                    own.tasks.pop_front();
+                    return true;
+                }
+            }
+            for (size_t i = 1; i < m_Size; ++i) {
+                Queue &victim = m_Queues[(worker + i) % m_Size];
+                std::lock_guard lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = victim.tasks.back();
+                    victim.tasks.pop_back();
+                    m_Steals.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// Run tasks until every queue is empty.
+        void work(const size_t worker) {
+            size_t task;
+            while (pop(worker, task)) {
+                m_Invoke(m_Context, task);
+                m_Tasks.fetch_add(1, std::memory_order_relaxed);
+                if (m_Remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) m_Remaining.notify_one();
+            }
+        }
+
+        void threadLoop(const size_t worker) {
+            uint64_t seen = 0;
+            while (true) {
+                {
+                    std::unique_lock lock(m_WakeMutex);
+                    m_Wake.wait(lock, [&] { return m_Stop || m_Batch != seen; });
+                    if (m_Stop) return;
+                    seen = m_Batch;
+                }
+                work(worker);
+            }
+        }
+
+    public:
+        /// @param threads Number of workers including the calling thread. 0 uses one per hardware thread.
+        explicit WorkStealingPool(const unsigned threads = 0)
+            : m_Size(std::max(1u, threads != 0 ? threads : std::thread::hardware_concurrency())),
+              m_Queues(std::make_unique<Queue[]>(m_Size)) {
+            m_Threads.reserve(m_Size - 1);
+            for (size_t i = 1; i < m_Size; ++i) m_Threads.emplace_back(&WorkStealingPool::threadLoop, this, i);
+        }
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        ~WorkStealingPool() {
+            {
+                std::lock_guard lock(m_WakeMutex);
+                m_Stop = true;
+            }
+            m_Wake.notify_all();
+            for (auto &thread: m_Threads) thread.join();
+        }
+
+        /// @return The number of workers including the calling thread.
+        [[nodiscard]] size_t size() const noexcept { return m_Size; }
+
+        /**
+         * Call fn(i) for every i in [0, count) and return once all calls finished. Must not be called from inside
+         * a task or from two threads at once.
+         * @param count The number of tasks.
+         * @param fn Callable taking a size_t, invoked concurrently from all workers.
+         */
+        template<typename F>
+        void parallelFor(const size_t count, F &&fn) {
+            if (m_Size == 1 || count <= 1) {
+                for (size_t i = 0; i < count; ++i) fn(i);
+                return;
+            }
+
+            using Fn = std::remove_reference_t<F>;
+            m_Invoke = [](void *context, const size_t index) { (*static_cast<Fn *>(context))(index); };
+            m_Context = const_cast<void *>(static_cast<const void *>(std::addressof(fn)));
+            m_Remaining.store(count, std::memory_order_relaxed);
+            for (size_t w = 0; w < m_Size; ++w) {
+                std::lock_guard lock(m_Queues[w].mutex);
+                for (size_t i = w * count / m_Size; i < (w + 1) * count / m_Size; ++i) m_Queues[w].tasks.push_back(i);
+            }
+            {
+                std::lock_guard lock(m_WakeMutex);
+                m_Batch++;
+            }
+            m_Wake.notify_all();
+            m_Batches++;
+
+            work(0);
+            for (size_t left; (left = m_Remaining.load(std::memory_order_acquire)) != 0;) m_Remaining.wait(left);
+        }
+
+        [[nodiscard]] WorkStealingPoolStats stats() const noexcept {
+            return {m_Batches, m_Tasks.load(std::memory_order_relaxed), m_Steals.load(std::memory_order_relaxed)};
+        }
+    };
+}
+
+#endif //X11TEST_WORKSTEALINGPOOL_H
@@ -0,0 +1,170 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BENCHSTATS_H
+#define X11TEST_BENCHSTATS_H
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace Bench {
+    /// Distribution of the samples of one benchmark case, e.g. nanoseconds per repetition.
+    struct Summary {
+        size_t count = 0;
+        double min = 0;
+        double median = 0;
+        double p99 = 0;
+        double max = 0;
+        double mean = 0;
+    };
+
+    /// Nearest-rank percentiles, so p99 of fewer than 100 samples is their maximum.
+    [[nodiscard]] inline Summary summarize(std::vector<double> samples) {
+        Summary summary{};
+        if (samples.empty()) return summary;
+        std::ranges::sort(samples);
+        const auto rank = [&](const double percentile) {
+            const auto index = static_cast<size_t>(std::ceil(percentile / 100 * static_cast<double>(samples.size())));
+            return samples[std::clamp<size_t>(index, 1, samples.size()) - 1];
+        };
+        summary.count = samples.size();
+        summary.min = samples.front();
+        summary.median = samples.size() % 2 == 1
+                             ? samples[samples.size() / 2]
+                             : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+        summary.p99 = rank(99);
+        summary.max = samples.back();
+        summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+        return summary;
+    }
+
+    /**
+     * Streams JSON with one value per line, so result files diff well between commits. Keys and values are written
+     * in call order; the caller is responsible for matching every begin with an end.
+     */
+    class JsonWriter {
+        std::ostream &m_Out;
+        std::vector<bool> m_HasItems{}; // per open object or array
+        bool m_AfterKey = false;
+
+        void separate() {
+            if (m_AfterKey) {
+                m_AfterKey = false;
+                return;
+            }
+            if (m_HasItems.empty()) return;
+            if (m_HasItems.back()) m_Out << ',';
+            m_HasItems.back() = true;
+            newline();
+        }
+
+        void newline() {
+            m_Out << '\n';
+            for (size_t i = 0; i < m_HasItems.size(); ++i) m_Out << "  ";
+        }
+
+        void string(const std::string_view text) {
+            m_Out << '"';
+            for (const char c: text) {
+                switch (c) {
+                    case '"': m_Out << "\\\"";
+                        break;
+                    case '\\': m_Out << "\\\\";
+                        break;
+                    case '\n': m_Out << "\\n";
+                        break;
+                    case '\t': m_Out << "\\t";
+                        break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            constexpr char hex[] = "0123456789abcdef";
+                            m_Out << "\\u00" << hex[c >> 4 & 0xF] << hex[c & 0xF];
+                        } else m_Out << c;
+                }
+            }
+            m_Out << '"';
+        }
+
+        JsonWriter &open(const char bracket) {
+            separate();
+            m_Out << bracket;
+            m_HasItems.push_back(false);
+            return *this;
+        }
+
+        JsonWriter &close(const char bracket) {
+            const bool hadItems = m_HasItems.back();
+            m_HasItems.pop_back();
+            if (hadItems) newline();
+            m_Out << bracket;
+            if (m_HasItems.empty()) m_Out << '\n';
+            return *this;
+        }
+
+    public:
+        explicit JsonWriter(std::ostream &out) : m_Out(out) {
+        }
+
+        JsonWriter &beginObject() { return open('{'); }
+        JsonWriter &endObject() { return close('}'); }
+        JsonWriter &beginArray() { return open('['); }
+        JsonWriter &endArray() { return close(']'); }
+
+        JsonWriter &key(const std::string_view name) {
+            separate();
+            string(name);
+            m_Out << ": ";
+            m_AfterKey = true;
+            return *this;
+        }
+
+        JsonWriter &value(const std::string_view text) {
+            separate();
+            string(text);
+            return *this;
+        }
+
+        JsonWriter &value(const char *text) { return value(std::string_view(text)); }
+
+        JsonWriter &value(const bool flag) {
+            separate();
+            m_Out << (flag ? "true" : "false");
+            return *this;
+        }
+
+        /// Non-finite numbers are written as null, JSON has no representation for them.
+        JsonWriter &value(const double number) {
+            separate();
+            if (!std::isfinite(number)) {
+                m_Out << "null";
+                return *this;
+            }
+            char buffer[32];
+            const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            m_Out << std::string_view(buffer, end - buffer);
+            return *this;
+        }
+
+        template<typename Int> requires std::is_integral_v<Int> && (!std::is_same_v<Int, bool>)
+        JsonWriter &value(const Int number) {
+            separate();
+            m_Out << number;
+            return *this;
+        }
+
+        template<typename T>
+        JsonWriter &field(const std::string_view name, const T &v) {
+            key(name);
+            return value(v);
+        }
+    };
+}
+
+#endif //X11TEST_BENCHSTATS_H
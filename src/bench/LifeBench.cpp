@@ -0,0 +1,375 @@
+//
+// Created by julian on 10/17/26.
+//
+
+// Headless stepping benchmark of the Game of Life engines. Every case seeds an engine, warms it up, then times
+// repetitions of a batch of generations and reports the median and p99 per generation, as a table and as JSON.
+// Boards that settle into a cycle are reported as settled without timings, and unbounded engines get no cells/ns, since
+// their work does not scale with the nominal board.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <ranges>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchStats.h"
+#include "../examples/life/CycleDetector.h"
+#include "../examples/life/Engines.h"
+#include "../examples/life/PatternIO.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /// Generations stepped one by one after the timed repetitions to tell whether the board settled. Cycles with
+    /// a shorter period are found whatever the number of generations timed before.
+    constexpr uint64_t settleCheckGenerations = 128;
+
+    /// Small well-known patterns, in plaintext rows of '.' and 'O'.
+    struct KnownPattern {
+        const char *name;
+        const char *rows;
+    };
+
+    constexpr KnownPattern knownPatterns[] = {
+        {"r-pentomino", ".OO\nOO.\n.O.\n"}, // methuselah, settles after 1103 generations
+        {"acorn", ".O.....\n...O...\nOO..OOO\n"}, // methuselah, settles after 5206 generations
+        {
+            "gosper-gun", // period 30, one glider per period
+            "........................O...........\n"
+            "......................O.O...........\n"
+            "............OO......OO............OO\n"
+            "...........O...O....OO............OO\n"
+            "OO........O.....O...OO..............\n"
+            "OO........O...O.OO....O.O...........\n"
+            "..........O.....O.......O...........\n"
+            "...........O...O....................\n"
+            "............OO......................\n"
+        },
+    };
+
+    struct Options {
+        std::vector<std::string> engines{"bits", "bytes", "rules", "hashlife"};
+        // 16384 and up take minutes and gigabytes per engine, ask for them with --sizes
+        std::vector<int> sizes{20, 64, 256, 1024, 4096};
+        std::vector<double> densities{0.05, 0.25, 0.5};
+        std::vector<std::string> patterns{"r-pentomino", "acorn", "gosper-gun"}; // names or pattern files
+        GameOfLife::LifeRule rule{};
+        GameOfLife::Kernel kernel = GameOfLife::Kernel::Auto;
+        unsigned threads = 0;
+        int repetitions = 15;
+        int minRepetitions = 3; // kept even if a case runs out of time
+        double repetitionMs = 20; // generations per repetition are chosen to take about this long
+        double warmupMs = 200;
+        double caseSeconds = 3; // repetitions stop early once a case took this long
+        uint32_t seed = 1;
+        std::string json{}; // "-" for stdout
+        std::string label{}; // e.g. the commit, copied into the JSON
+    };
+
+    /// One seeded board: a random soup of the given density, or a pattern centred on the board.
+    struct Seed {
+        std::string name;
+        double density = 0; // for soups
+        std::string pattern{}; // known pattern name or file
+    };
+
+    struct Result {
+        std::string engine, kernel, seed, rule;
+        int width = 0, height = 0;
+        double density = 0;
+        uint64_t warmupGenerations = 0;
+        uint64_t generationsPerRepetition = 0;
+        Bench::Summary nsPerGeneration{};
+        uint64_t population = 0; // after the last repetition
+        bool bounded = true; // cells/ns only means something if width x height is what the engine simulates
+        std::optional<GameOfLife::Cycle> cycle{}; // the board settled into it, so the timings do not count
+        std::string skipped{}; // why the case did not run, empty if it did
+    };
+
+    template<typename T, typename Parse>
+    std::vector<T> parseList(const std::string_view list, Parse &&parse) {
+        std::vector<T> out;
+        for (const auto part: std::views::split(list, ',')) {
+            const std::string item(part.begin(), part.end());
+            if (!item.empty()) out.push_back(parse(item));
+        }
+        return out;
+    }
+
+    /// @throws std::invalid_argument on unknown arguments or values.
+    Options parseOptions(const int argc, char **argv) {
+        Options options;
+        const auto text = [](const std::string &item) { return item; };
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            const auto valueOf = [&](const std::string_view name) { return arg.substr(name.size()); };
+            if (arg.starts_with("--engines=")) options.engines = parseList<std::string>(valueOf("--engines="), text);
+            else if (arg.starts_with("--sizes="))
+                options.sizes = parseList<int>(valueOf("--sizes="), [](const std::string &item) {
+                    return std::stoi(item);
+                });
+            else if (arg.starts_with("--densities="))
+                options.densities = parseList<double>(valueOf("--densities="), [](const std::string &item) {
+                    return std::stod(item);
+                });
+            else if (arg.starts_with("--patterns="))
+                options.patterns = parseList<std::string>(valueOf("--patterns="), text);
+            else if (arg.starts_with("--rule=")) options.rule = GameOfLife::LifeRule::parse(valueOf("--rule="));
+            else if (arg.starts_with("--kernel=")) options.kernel = GameOfLife::kernelParse(valueOf("--kernel="));
+            else if (arg.starts_with("--threads="))
+                options.threads = std::stoul(std::string(valueOf("--threads=")));
+            else if (arg.starts_with("--repetitions="))
+                options.repetitions = std::max(1, std::stoi(std::string(valueOf("--repetitions="))));
+            else if (arg.starts_with("--warmup-ms="))
+                options.warmupMs = std::stod(std::string(valueOf("--warmup-ms=")));
+            else if (arg.starts_with("--case-seconds="))
+                options.caseSeconds = std::stod(std::string(valueOf("--case-seconds=")));
+            else if (arg.starts_with("--seed=")) options.seed = std::stoul(std::string(valueOf("--seed=")));
+            else if (arg.starts_with("--json=")) options.json = valueOf("--json=");
+            else if (arg.starts_with("--label=")) options.label = valueOf("--label=");
+            else if (arg == "--quick") {
+                options.sizes = {20, 256, 1024};
+                options.repetitions = 5;
+                options.warmupMs = 50;
+                options.caseSeconds = 0.5;
+            } else throw std::invalid_argument("Unknown argument: " + std::string(arg));
+        }
+        options.minRepetitions = std::min(options.minRepetitions, options.repetitions);
+        return options;
+    }
+
+    void seedSoup(GameOfLife::LifeEngine &engine, const double density, const uint32_t seed) {
+        std::mt19937_64 rng(seed);
+        // one draw per cell, alive if it falls below the density scaled to the range of the generator
+        const uint64_t threshold = density >= 1 ? ~uint64_t{0} : static_cast<uint64_t>(std::ldexp(density, 64));
+        // runs of live cells go in with setSpan, which the row based engines write a word at a time
+        for (int y = 0; y < engine.height(); ++y) {
+            int run = 0;
+            for (int x = 0; x < engine.width(); ++x) {
+                if (rng() < threshold) {
+                    run++;
+                    continue;
+                }
+                if (run > 0) engine.setSpan(x - run, y, run, true);
+                run = 0;
+            }
+            if (run > 0) engine.setSpan(engine.width() - run, y, run, true);
+        }
+    }
+
+    /// @throws std::runtime_error if a pattern file cannot be loaded.
+    void seedPattern(GameOfLife::LifeEngine &engine, const std::string &pattern) {
+        for (const auto &[name, rows]: knownPatterns) {
+            if (pattern != name) continue;
+            std::istringstream in(rows);
+            std::vector<std::string> lines;
+            for (std::string line; std::getline(in, line);) lines.push_back(line);
+            const int x0 = (engine.width() - static_cast<int>(lines[0].size())) / 2;
+            const int y0 = (engine.height() - static_cast<int>(lines.size())) / 2;
+            for (size_t y = 0; y < lines.size(); ++y)
+                for (size_t x = 0; x < lines[y].size(); ++x)
+                    if (lines[y][x] == 'O') engine.set(x0 + static_cast<int>(x), y0 + static_cast<int>(y), true);
+            return;
+        }
+        GameOfLife::patternLoadCentred(engine, pattern);
+    }
+
+    uint64_t population(const GameOfLife::LifeEngine &engine) {
+        GameOfLife::BitBoard cells;
+        engine.snapshot(cells);
+        return cells.population();
+    }
+
+    Result runCase(const Options &options, X11App::WorkStealingPool &pool, const std::string &engineName,
+                   const int size, const Seed &seed) {
+        Result result{
+            .engine = engineName, .kernel = "", .seed = seed.name, .rule = options.rule.toString(),
+            .width = size, .height = size, .density = seed.density
+        };
+
+        std::unique_ptr<GameOfLife::LifeEngine> engine;
+        try {
+            engine = GameOfLife::engineCreate({
+                .engine = engineName, .rule = options.rule, .kernel = options.kernel, .width = size, .height = size,
+                .pool = &pool
+            });
+        } catch (const std::invalid_argument &e) {
+            result.skipped = e.what();
+            return result;
+        }
+        if (engineName == "bits") result.kernel = GameOfLife::kernelName(GameOfLife::kernelResolve(options.kernel));
+        result.bounded = engine->bounded();
+
+        if (seed.pattern.empty()) seedSoup(*engine, seed.density, options.seed);
+        else seedPattern(*engine, seed.pattern);
+
+        // warm up caches, the pool and the engine's own structures, and estimate the cost of a generation
+        const auto warmupStart = Clock::now();
+        std::chrono::duration<double, std::milli> warmup{};
+        do {
+            engine->step();
+            result.warmupGenerations++;
+            warmup = Clock::now() - warmupStart;
+        } while (warmup.count() < options.warmupMs);
+
+        const double msPerGeneration = warmup.count() / static_cast<double>(result.warmupGenerations);
+        result.generationsPerRepetition = std::max<uint64_t>(
+            1, static_cast<uint64_t>(options.repetitionMs / std::max(msPerGeneration, 1e-6)));
+
+        std::vector<double> samples;
+        const auto caseStart = Clock::now();
+        for (int repetition = 0; repetition < options.repetitions; ++repetition) {
+            const auto start = Clock::now();
+            engine->stepMany(result.generationsPerRepetition);
+            const std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+            samples.push_back(elapsed.count() / static_cast<double>(result.generationsPerRepetition));
+
+            const std::chrono::duration<double> total = Clock::now() - caseStart;
+            if (repetition + 1 >= options.minRepetitions && total.count() >= options.caseSeconds) break;
+        }
+        result.nsPerGeneration = Bench::summarize(std::move(samples));
+        result.population = population(*engine);
+
+        // a dead or periodic board is nearly free for engines that skip empty space or memoise, HashLife steps
+        // it in no time at all, so only a board that is still changing makes a result. Every generation of the
+        // check is hashed, so the period does not have to divide the generations of a repetition.
+        GameOfLife::CycleDetector cycles(settleCheckGenerations);
+        cycles.push(engine->generation(), engine->hash());
+        for (uint64_t i = 0; i < settleCheckGenerations && !cycles.cycle(); ++i) {
+            engine->step();
+            cycles.push(engine->generation(), engine->hash());
+        }
+        result.cycle = cycles.cycle();
+        return result;
+    }
+
+    double generationsPerSecond(const Result &result) { return 1e9 / result.nsPerGeneration.median; }
+
+    double cellsPerNs(const Result &result) {
+        return static_cast<double>(result.width) * result.height / result.nsPerGeneration.median;
+    }
+
+    void writeJson(std::ostream &out, const Options &options, const unsigned threads,
+                   const std::vector<Result> &results) {
+        Bench::JsonWriter json(out);
+        json.beginObject()
+                .field("benchmark", "life")
+                .field("version", 3)
+                .field("label", options.label)
+                .field("threads", threads)
+                .field("hardwareThreads", std::thread::hardware_concurrency())
+                .field("rule", options.rule.toString())
+                .field("repetitions", options.repetitions)
+                .field("warmupMs", options.warmupMs)
+                .field("repetitionMs", options.repetitionMs);
+        json.key("results").beginArray();
+        for (const Result &result: results) {
+            json.beginObject()
+                    .field("engine", result.engine)
+                    .field("kernel", result.kernel)
+                    .field("seed", result.seed)
+                    .field("density", result.density)
+                    .field("width", result.width)
+                    .field("height", result.height);
+            if (!result.skipped.empty()) {
+                json.field("skipped", result.skipped).endObject();
+                continue;
+            }
+            json.field("warmupGenerations", result.warmupGenerations)
+                    .field("generationsPerRepetition", result.generationsPerRepetition)
+                    .field("population", result.population)
+                    .field("settled", result.cycle.has_value())
+                    .field("comparable", result.bounded);
+            if (result.cycle) {
+                json.field("period", result.cycle->period).endObject();
+                continue;
+            }
+            json
+                    .field("repetitions", result.nsPerGeneration.count)
+                    .field("nsPerGenerationMedian", result.nsPerGeneration.median)
+                    .field("nsPerGenerationP99", result.nsPerGeneration.p99)
+                    .field("nsPerGenerationMin", result.nsPerGeneration.min)
+                    .field("nsPerGenerationMean", result.nsPerGeneration.mean)
+                    .field("generationsPerSecond", generationsPerSecond(result));
+            if (result.bounded) json.field("cellsPerNs", cellsPerNs(result));
+            json.endObject();
+        }
+        json.endArray().endObject();
+    }
+}
+
+/// Arguments: --engines=<bits,bytes,rules,hashlife>, --sizes=<20,64,...>, --densities=<0.05,...>,
+/// --patterns=<r-pentomino,acorn,gosper-gun or files>, --rule=<B3/S23 ...>, --kernel=<auto|scalar|avx2|avx512>,
+/// --threads=<n>, --repetitions=<n>, --warmup-ms=<ms>, --case-seconds=<s>, --seed=<n>, --json=<path or ->,
+/// --label=<text> and --quick for a short run on small boards.
+int main(const int argc, char **argv) {
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return -1;
+    }
+
+    X11App::WorkStealingPool pool(options.threads);
+    std::vector<Seed> seeds;
+    for (const double density: options.densities) seeds.push_back({std::format("soup-{}", density), density});
+    for (const std::string &pattern: options.patterns) seeds.push_back({pattern, 0, pattern});
+
+    // the table goes to stderr when the JSON goes to stdout, so the JSON can be piped
+    std::ostream &log = options.json == "-" ? std::cerr : std::cout;
+    log << std::format("{} threads, rule {}\n", pool.size(), options.rule.toString());
+    log << std::format("{:<9} {:<7} {:>11} {:<18} {:>12} {:>12} {:>12} {:>9}\n", "engine", "kernel", "board",
+                       "seed", "gen/s", "median ns", "p99 ns", "cells/ns");
+
+    std::vector<Result> results;
+    for (const std::string &engine: options.engines) {
+        for (const int size: options.sizes) {
+            for (const Seed &seed: seeds) {
+                try {
+                    results.push_back(runCase(options, pool, engine, size, seed));
+                } catch (const std::exception &e) {
+                    fprintf(stderr, "Error: %s\n", e.what());
+                    return -1;
+                }
+                const Result &result = results.back();
+                const std::string board = std::format("{}x{}", size, size);
+                if (!result.skipped.empty()) {
+                    log << std::format("{:<9} {:<7} {:>11} {:<18} skipped: {}\n", engine, result.kernel, board,
+                                       seed.name, result.skipped);
+                    continue;
+                }
+                if (result.cycle) {
+                    log << std::format("{:<9} {:<7} {:>11} {:<18} settled: {}, population {}\n", engine,
+                                       result.kernel, board, seed.name, result.cycle->toString(), result.population);
+                    continue;
+                }
+                // an unbounded engine simulates the plane, not the nominal board, so it has no cells/ns
+                const std::string cells = result.bounded ? std::format("{:.3f}", cellsPerNs(result)) : "-";
+                log << std::format("{:<9} {:<7} {:>11} {:<18} {:>12.0f} {:>12.0f} {:>12.0f} {:>9}\n", engine,
+                                   result.kernel, board, seed.name, generationsPerSecond(result),
+                                   result.nsPerGeneration.median, result.nsPerGeneration.p99, cells);
+            }
+        }
+    }
+
+    if (options.json == "-") writeJson(std::cout, options, pool.size(), results);
+    else if (!options.json.empty()) {
+        std::ofstream out(options.json);
+        writeJson(out, options, pool.size(), results);
+        if (!out) {
+            fprintf(stderr, "Error: could not write %s\n", options.json.c_str());
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,452 @@
+//
+// Created by julian on 10/17/26.
+//
+
+// Rendering benchmark of the App draw primitives. Every scene is drawn through windowProcessRedrawQueue into a
+// window of a (virtual) X server, and each frame is forced to completion with XSync, so the time includes the
+// server's work. Requests per frame come from XNextRequest, bytes per frame from the wchar counter of
+// /proc/self/io, which counts everything written to the X connection.
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <poll.h>
+#include <random>
+#include <ranges>
+#include <spawn.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include <sys/wait.h>
+
+#include "BenchStats.h"
+#include "../../core/App.h"
+#include "../examples/life/BitBoard.h"
+
+extern char **environ;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int benchWindow = 1;
+    constexpr int windowWidth = 1024;
+    constexpr int windowHeight = 640;
+    constexpr int gridCellSize = 4; // pixels per cell of the cell-grid scene, grid lines included
+
+    struct Options {
+        std::vector<std::string> scenes{
+            "rects", "rects-batched", "lines", "lines-batched", "text", "polygons", "cell-grid"
+        };
+        int primitives = 2000; // per frame, text and polygon scenes draw a tenth of it
+        int frames = 200;
+        int warmupFrames = 20;
+        bool single = true, doubleBuffered = true; // buffering modes to measure
+        std::optional<std::string> xvfb{}; // start a virtual server on this display, e.g. ":99", or a free one if empty
+        uint32_t seed = 1;
+        std::string json{}; // "-" for stdout
+        std::string label{};
+    };
+
+    struct Result {
+        std::string scene;
+        bool doubleBuffered = false;
+        int primitives = 0;
+        Bench::Summary frameMs{};
+        double requestsPerFrame = 0;
+        double bytesPerFrame = -1; // -1 without /proc/self/io
+        std::string skipped{};
+    };
+
+    /// @return Bytes this process wrote through write-like calls so far, -1 if /proc/self/io is unavailable.
+    long long bytesWritten() {
+        std::ifstream io("/proc/self/io");
+        std::string key;
+        long long value = 0;
+        while (io >> key >> value)
+            if (key == "wchar:") return value;
+        return -1;
+    }
+
+    /**
+     * An Xvfb server on its own display for the lifetime of the object, so the benchmark runs on machines without
+     * a display and without disturbing one. DISPLAY is pointed at it.
+     */
+    class VirtualServer {
+        pid_t m_Pid = -1;
+
+    public:
+        /// @param display The display to run on, e.g. ":99", empty for the first free one.
+        /// @throws std::runtime_error if Xvfb cannot be started or does not report its display within 5 s.
+        explicit VirtualServer(const std::string &display) {
+            // Xvfb writes its display number to -displayfd once it accepts connections, which also tells which free
+            // display it picked, so another server on a fixed display is neither reused nor fought over
+            int fds[2];
+            if (pipe(fds) != 0) throw std::runtime_error("Could not create a pipe for Xvfb");
+            fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+            const std::string screen = std::format("{}x{}x24", windowWidth + 256, windowHeight + 256);
+            const std::string displayFd = std::to_string(fds[1]);
+            std::vector<const char *> argv{"Xvfb"};
+            if (!display.empty()) argv.push_back(display.c_str());
+            for (const char *arg: {"-displayfd", displayFd.c_str(), "-screen", "0", screen.c_str(), "-nolisten", "tcp"})
+                argv.push_back(arg);
+            argv.push_back(nullptr);
+            const int spawned = posix_spawnp(&m_Pid, "Xvfb", nullptr, nullptr, const_cast<char **>(argv.data()),
+                                             environ);
+            close(fds[1]);
+            if (spawned != 0) {
+                close(fds[0]);
+                m_Pid = -1;
+                throw std::runtime_error("Could not start Xvfb, is it installed?");
+            }
+
+            std::string number;
+            bool reported = false;
+            const auto deadline = Clock::now() + std::chrono::seconds(5);
+            pollfd pipe{fds[0], POLLIN, 0};
+            while (!reported) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+                char c = 0;
+                // Xvfb exiting, e.g. because the display is taken, closes the pipe
+                if (left.count() <= 0 || poll(&pipe, 1, static_cast<int>(left.count())) <= 0 ||
+                    read(fds[0], &c, 1) != 1)
+                    break;
+                if (c == '\n') reported = !number.empty();
+                else number += c;
+            }
+            close(fds[0]);
+            if (!reported) {
+                stop();
+                throw std::runtime_error("Xvfb did not report a display" + (display.empty() ? "" : " for " + display));
+            }
+            setenv("DISPLAY", (":" + number).c_str(), 1);
+        }
+
+        VirtualServer(const VirtualServer &) = delete;
+        VirtualServer &operator=(const VirtualServer &) = delete;
+
+        ~VirtualServer() { stop(); }
+
+        void stop() noexcept {
+            if (m_Pid <= 0) return;
+            kill(m_Pid, SIGTERM);
+            waitpid(m_Pid, nullptr, 0);
+            m_Pid = -1;
+        }
+    };
+
+    class RenderBenchApp final : public X11App::App {
+        friend App;
+
+        const Options &options;
+        std::vector<Result> &results;
+        std::mt19937 rng;
+        std::vector<XColor> palette{};
+        const std::string font;
+        std::function<void()> drawScene{}; // called by handleExpose with the current scene
+
+        // scene data, generated once per scene so frames only measure drawing
+        std::vector<XRectangle> rects{};
+        std::vector<XSegment> segments{};
+        std::vector<std::vector<XPoint>> polygons{};
+        GameOfLife::BitBoard board{};
+
+        RenderBenchApp(Display *display, const Options &options, std::vector<Result> &results)
+            : App(display), options(options), results(results), rng(options.seed),
+              font(X11App::FontDescriptor("helvetica", 120).toString()) {
+        }
+
+        int random(const int max) { return static_cast<int>(rng() % static_cast<uint32_t>(max)); }
+
+        const XColor &color(const size_t i) const { return palette[i % palette.size()]; }
+
+        void handleExpose(XExposeEvent &) override { drawScene(); }
+
+        /// Drop the events the server sent, nothing in the benchmark reacts to them.
+        void eventsDrain() const {
+            XEvent event;
+            while (XPending(m_Display)) XNextEvent(m_Display, &event);
+        }
+
+        /// @return The drawing function of the scene, after generating its data.
+        /// @throws std::invalid_argument if the scene is unknown.
+        /// @throws std::runtime_error if the server lacks a font the scene needs.
+        std::function<void()> sceneCreate(const std::string &scene, int &primitives) {
+            const int count = options.primitives;
+            if (scene == "rects" || scene == "rects-batched") {
+                primitives = count;
+                rects.clear();
+                for (int i = 0; i < count; ++i)
+                    rects.push_back({
+                        static_cast<short>(random(windowWidth)), static_cast<short>(random(windowHeight)),
+                        static_cast<unsigned short>(1 + random(40)), static_cast<unsigned short>(1 + random(40))
+                    });
+                if (scene == "rects") {
+                    return [this] {
+                        for (size_t i = 0; i < rects.size(); ++i)
+                            drawRectangle(benchWindow, color(i), rects[i].x, rects[i].y, rects[i].width,
+                                          rects[i].height);
+                    };
+                }
+                return [this] {
+                    auto &batch = batchBegin(benchWindow);
+                    for (size_t i = 0; i < rects.size(); ++i)
+                        batch.rectangle(color(i), rects[i].x, rects[i].y, rects[i].width, rects[i].height);
+                    batchSubmit();
+                };
+            }
+            if (scene == "lines" || scene == "lines-batched") {
+                primitives = count;
+                segments.clear();
+                for (int i = 0; i < count; ++i)
+                    segments.push_back({
+                        static_cast<short>(random(windowWidth)), static_cast<short>(random(windowHeight)),
+                        static_cast<short>(random(windowWidth)), static_cast<short>(random(windowHeight))
+                    });
+                if (scene == "lines") {
+                    return [this] {
+                        for (size_t i = 0; i < segments.size(); ++i)
+                            drawLine(benchWindow, color(i), segments[i].x1, segments[i].y1, segments[i].x2,
+                                     segments[i].y2);
+                    };
+                }
+                return [this] {
+                    auto &batch = batchBegin(benchWindow);
+                    for (size_t i = 0; i < segments.size(); ++i)
+                        batch.line(color(i), segments[i].x1, segments[i].y1, segments[i].x2, segments[i].y2);
+                    batchSubmit();
+                };
+            }
+            if (scene == "text") {
+                // the scene is drawn under the noexcept redraw queue, so a font the server does not have has to
+                // throw here, where it skips the scene; the font stays cached for the frames
+                (void) textMeasure(font, "");
+                primitives = std::max(1, count / 10);
+                rects.clear();
+                for (int i = 0; i < primitives; ++i)
+                    rects.push_back({
+                        static_cast<short>(random(windowWidth - 200)),
+                        static_cast<short>(20 + random(windowHeight - 20)),
+                        0, 0
+                    });
+                return [this] {
+                    for (size_t i = 0; i < rects.size(); ++i)
+                        drawText(benchWindow, color(i), rects[i].x, rects[i].y, font,
+                                 "The quick brown fox jumps over the lazy dog");
+                };
+            }
+            if (scene == "polygons") {
+                primitives = std::max(1, count / 10);
+                polygons.clear();
+                for (int i = 0; i < primitives; ++i) {
+                    const int x = random(windowWidth - 60), y = random(windowHeight - 60);
+                    std::vector<XPoint> points;
+                    for (int p = 0; p < 6; ++p)
+                        points.push_back({static_cast<short>(x + random(60)), static_cast<short>(y + random(60))});
+                    polygons.push_back(std::move(points));
+                }
+                return [this] {
+                    for (size_t i = 0; i < polygons.size(); ++i) drawPolygon(benchWindow, color(i), polygons[i]);
+                };
+            }
+            if (scene == "cell-grid") {
+                // A quarter filled board drawn as one rectangle per live cell plus the grid lines, all in one batch.
+                // It stands in for a full redraw of the Game of Life example as it was before delta rendering and
+                // the cached grid layer. The example now draws only the changed cells and renders the grid when the
+                // view changes, so this is the worst case of an expose, not what a typical frame of it sends.
+                board = GameOfLife::BitBoard(windowWidth / gridCellSize, windowHeight / gridCellSize);
+                for (int y = 0; y < board.height(); ++y)
+                    for (int x = 0; x < board.width(); ++x)
+                        if (random(4) == 0) board.set(x, y, true);
+                primitives = static_cast<int>(board.population()) + board.width() + board.height() + 2;
+                return [this] {
+                    const XColor &black = palette[0], &gray = palette[1];
+                    auto &batch = batchBegin(benchWindow);
+                    for (int y = 0; y < board.height(); ++y)
+                        for (int x = 0; x < board.width(); ++x)
+                            if (board.get(x, y))
+                                batch.rectangle(black, x * gridCellSize, y * gridCellSize, gridCellSize - 1,
+                                                gridCellSize - 1);
+                    for (int x = 0; x <= board.width(); ++x)
+                        batch.line(gray, x * gridCellSize, 0, x * gridCellSize, board.height() * gridCellSize);
+                    for (int y = 0; y <= board.height(); ++y)
+                        batch.line(gray, 0, y * gridCellSize, board.width() * gridCellSize, y * gridCellSize);
+                    batchSubmit();
+                };
+            }
+            throw std::invalid_argument("Unknown scene: " + scene);
+        }
+
+        /// One frame: damage the whole window, redraw it and wait until the server is done.
+        void frame() {
+            windowScheduleRedraw(benchWindow);
+            windowProcessRedrawQueue();
+            XSync(m_Display, False);
+        }
+
+        Result runScene(const std::string &scene, const bool doubleBuffered) {
+            Result result{.scene = scene, .doubleBuffered = doubleBuffered};
+            try {
+                drawScene = sceneCreate(scene, result.primitives);
+            } catch (const std::exception &e) {
+                result.skipped = e.what();
+                return result;
+            }
+            windowSetDoubleBuffered(benchWindow, doubleBuffered);
+
+            for (int i = 0; i < options.warmupFrames; ++i) frame();
+            eventsDrain();
+
+            std::vector<double> frameMs;
+            unsigned long requests = 0;
+            long long bytes = 0;
+            for (int i = 0; i < options.frames; ++i) {
+                const unsigned long firstRequest = XNextRequest(m_Display);
+                const long long firstBytes = bytesWritten();
+                const auto start = Clock::now();
+                frame();
+                const std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+                // XSync itself sends one request
+                requests += XNextRequest(m_Display) - firstRequest - 1;
+                bytes = firstBytes < 0 || bytes < 0 ? -1 : bytes + bytesWritten() - firstBytes;
+                frameMs.push_back(elapsed.count());
+                eventsDrain();
+            }
+
+            result.frameMs = Bench::summarize(std::move(frameMs));
+            result.requestsPerFrame = static_cast<double>(requests) / options.frames;
+            result.bytesPerFrame = bytes < 0 ? -1 : static_cast<double>(bytes) / options.frames;
+            return result;
+        }
+
+    public:
+        void run() override {
+            windowOpen(benchWindow, 0, 0, windowWidth, windowHeight, ExposureMask, "RenderBench");
+            XSync(m_Display, False);
+            for (const auto &[r, g, b]: {
+                     std::tuple<u16, u16, u16>{0, 0, 0}, {32000, 32000, 32000}, {65535, 0, 0}, {0, 40000, 0},
+                     {0, 0, 65535}, {50000, 30000, 0}, {40000, 0, 40000}, {0, 40000, 40000}
+                 })
+                palette.push_back(colorCreate(r, g, b));
+
+            for (const std::string &scene: options.scenes) {
+                for (const bool doubleBuffered: {false, true}) {
+                    if (doubleBuffered ? !options.doubleBuffered : !options.single) continue;
+                    results.push_back(runScene(scene, doubleBuffered));
+                }
+            }
+            windowClose(benchWindow);
+        }
+    };
+
+    /// @throws std::invalid_argument on unknown arguments or values.
+    Options parseOptions(const int argc, char **argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            if (arg.starts_with("--scenes=")) {
+                options.scenes.clear();
+                for (const auto part: std::views::split(arg.substr(9), ','))
+                    options.scenes.emplace_back(part.begin(), part.end());
+            } else if (arg.starts_with("--primitives="))
+                options.primitives = std::max(1, std::stoi(std::string(arg.substr(13))));
+            else if (arg.starts_with("--frames=")) options.frames = std::max(1, std::stoi(std::string(arg.substr(9))));
+            else if (arg.starts_with("--warmup-frames="))
+                options.warmupFrames = std::max(0, std::stoi(std::string(arg.substr(16))));
+            else if (arg == "--single-buffered") options.doubleBuffered = false;
+            else if (arg == "--double-buffered") options.single = false;
+            else if (arg == "--xvfb") options.xvfb = "";
+            else if (arg.starts_with("--xvfb=")) options.xvfb = arg.substr(7);
+            else if (arg.starts_with("--seed=")) options.seed = std::stoul(std::string(arg.substr(7)));
+            else if (arg.starts_with("--json=")) options.json = arg.substr(7);
+            else if (arg.starts_with("--label=")) options.label = arg.substr(8);
+            else throw std::invalid_argument("Unknown argument: " + std::string(arg));
+        }
+        return options;
+    }
+
+    void writeJson(std::ostream &out, const Options &options, const std::vector<Result> &results) {
+        Bench::JsonWriter json(out);
+        json.beginObject()
+                .field("benchmark", "render")
+                .field("version", 1)
+                .field("label", options.label)
+                .field("display", std::getenv("DISPLAY") ? std::getenv("DISPLAY") : "")
+                .field("windowWidth", windowWidth)
+                .field("windowHeight", windowHeight)
+                .field("frames", options.frames);
+        json.key("results").beginArray();
+        for (const Result &result: results) {
+            json.beginObject()
+                    .field("scene", result.scene)
+                    .field("doubleBuffered", result.doubleBuffered)
+                    .field("primitives", result.primitives);
+            if (!result.skipped.empty()) {
+                json.field("skipped", result.skipped).endObject();
+                continue;
+            }
+            json.field("frameMsMedian", result.frameMs.median)
+                    .field("frameMsP99", result.frameMs.p99)
+                    .field("frameMsMin", result.frameMs.min)
+                    .field("frameMsMean", result.frameMs.mean)
+                    .field("requestsPerFrame", result.requestsPerFrame)
+                    .field("bytesPerFrame", result.bytesPerFrame)
+                    .endObject();
+        }
+        json.endArray().endObject();
+    }
+}
+
+/// Arguments: --scenes=<rects,rects-batched,lines,lines-batched,text,polygons,cell-grid>, --primitives=<n>,
+/// --frames=<n>, --warmup-frames=<n>, --single-buffered or --double-buffered to measure only one mode,
+/// --xvfb[=<display>] to start a virtual server (default the first free display), --seed=<n>, --json=<path or ->
+/// and --label=<text>.
+int main(const int argc, char **argv) {
+    Options options;
+    std::vector<Result> results;
+    try {
+        options = parseOptions(argc, argv);
+        std::unique_ptr<VirtualServer> server;
+        if (options.xvfb.has_value()) server = std::make_unique<VirtualServer>(*options.xvfb);
+        else if (std::getenv("DISPLAY") == nullptr)
+            throw std::runtime_error("DISPLAY is not set, pass --xvfb to start a virtual server");
+
+        const auto app = X11App::App::Create<RenderBenchApp>(false, options, results);
+        app->run();
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return -1;
+    }
+
+    std::ostream &log = options.json == "-" ? std::cerr : std::cout;
+    log << std::format("{:<14} {:<7} {:>10} {:>10} {:>10} {:>10} {:>12}\n", "scene", "buffer", "primitives",
+                       "median ms", "p99 ms", "requests", "bytes");
+    for (const Result &result: results) {
+        const char *buffer = result.doubleBuffered ? "double" : "single";
+        if (!result.skipped.empty()) {
+            log << std::format("{:<14} {:<7} skipped: {}\n", result.scene, buffer, result.skipped);
+            continue;
+        }
+        log << std::format("{:<14} {:<7} {:>10} {:>10.3f} {:>10.3f} {:>10.0f} {:>12.0f}\n", result.scene, buffer,
+                           result.primitives, result.frameMs.median, result.frameMs.p99, result.requestsPerFrame,
+                           result.bytesPerFrame);
+    }
+
+    if (options.json == "-") writeJson(std::cout, options, results);
+    else if (!options.json.empty()) {
+        std::ofstream out(options.json);
+        writeJson(out, options, results);
+        if (!out) {
+            fprintf(stderr, "Error: could not write %s\n", options.json.c_str());
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -5,115 +5,465 @@
 #include "GameOfLife.h"
 
 #include <algorithm>
+#include <cmath>
 #include <ranges>
-#include <unistd.h>
+#include <span>
 
-// todo: create separate thread for input handling
 namespace GameOfLife {
     void GameOfLifeApp::run() {
         windowOpen(MAIN_WINDOW, 100, 100, 550, 300,
                    defaultMask, "Test Window 1");
+        windowSetDoubleBuffered(MAIN_WINDOW, true);
+        layerSet(MAIN_WINDOW, [this](const int winId, const unsigned int width, const unsigned int height) {
+            // the layer is rendered again whenever the view or the window size changes, and so are the cells in view
+            simulationUpdateWindow(static_cast<int>(width), static_cast<int>(height));
+            drawGrid(winId, width, height);
+        });
+        const auto attrs = windowGetAttributes(MAIN_WINDOW);
+        viewport.fit(home, attrs.width, attrs.height);
+        simulationUpdateWindow(attrs.width, attrs.height);
+        // generations are computed on their own thread and only picked up here, so the frame rate stays steady
+        // however expensive a step is
+        inputThreadStart();
+        simulation.start();
 
-        auto lastTime = std::chrono::high_resolution_clock::now();
-        while (running) {
-            handleAllQueuedEvents();
+        frameLoopRun({.targetFps = 60, .allocationBudget = 0});
+        simulation.stop();
+    }
 
-            if (keyIsPressed(XK_Escape) || !windowCheckOpen(MAIN_WINDOW)) break;
-            if (keyIsPressed(XK_space)) {
-                isPaused = !isPaused;
-                windowScheduleRedraw(MAIN_WINDOW);
-            }
+    void GameOfLifeApp::frameUpdate() {
+        if (keyIsPressed(XK_Escape) || !windowCheckOpen(MAIN_WINDOW)) {
+            frameLoopStop();
+            return;
+        }
+        if (keyIsPressed(XK_space)) {
+            isPaused = !isPaused;
+            simulationUpdateMode();
+            windowScheduleRedraw(MAIN_WINDOW, pausedTextArea());
+        }
+        if (keyIsPressed(XK_m)) {
+            isMaxSpeed = !isMaxSpeed;
+            simulationUpdateMode();
+        }
+        if (keyIsPressed(XK_f)) simulation.fastForward(fastForwardGenerations);
+        if (keyIsPressed(XK_Up)) {
+            stepLog2 = std::min(stepLog2 + 1, boardBounded ? maxBoundedStepLog2 : maxUnboundedStepLog2);
+            simulation.setStepLog2(stepLog2);
+        }
+        if (keyIsPressed(XK_Down)) {
+            stepLog2 = std::max(stepLog2 - 1, 0);
+            simulation.setStepLog2(stepLog2);
+        }
+        if (keyIsPressed(XK_Home)) {
+            const auto attrs = windowGetAttributes(MAIN_WINDOW);
+            viewport.fit(home, attrs.width, attrs.height);
+            layerInvalidate(MAIN_WINDOW);
+        }
+        if (keyIsPressed(XK_d)) {
+            deltaRendering = !deltaRendering;
+            drawnValid = false;
+            windowScheduleRedraw(MAIN_WINDOW);
+        }
+        if (keyIsPressed(XK_s)) snapshotSave();
+        if (keyIsPressed(XK_c)) snapshotCheckpoint();
+        if (keyIsPressed(XK_p)) traceToggle();
+        for (const std::string &result: checkpoints.takeResults()) std::cout << result << std::endl;
+
+        snapshotAdopt();
+    }
+
+    void GameOfLifeApp::snapshotSave() const {
+        if (snapshot == nullptr) return;
+        const std::string path = "life-" + std::to_string(snapshot->generation) + ".rle";
+        try {
+            std::cout << "Saved " << path << ": " << patternSave(snapshot->cells, path, PatternFormat::Rle, boardRule).
+                    toString() << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    void GameOfLifeApp::snapshotCheckpoint() {
+        if (snapshot == nullptr) return;
+        if (!boardBounded) {
+            simulation.capture();
+            return;
+        }
+        // the copy is the only work on this thread, encoding and writing happen in the background
+        if (!checkpoints.submit(snapshot->cells, snapshot->generation, boardRule, checkpointPath))
+            std::cerr << "Still writing the last checkpoint" << std::endl;
+    }
+
+    void GameOfLifeApp::checkpointCapture(const LifeEngine &simulated) {
+        const CellRect extent = simulated.extent();
+        if (static_cast<uint64_t>(extent.width) * static_cast<uint64_t>(extent.height) > maxCheckpointCells) {
+            std::cerr << "Not saving a checkpoint, the live cells span " << extent.width << " x " << extent.height
+                      << " cells" << std::endl;
+            return;
+        }
+        BitBoard cells;
+        simulated.snapshotArea(cells, extent);
+        if (!checkpoints.submit(std::move(cells), simulated.generation(), boardRule, checkpointPath, extent.x,
+                                extent.y))
+            std::cerr << "Still writing the last checkpoint" << std::endl;
+    }
+
+    void GameOfLifeApp::traceToggle() {
+#if PROFILING
+        X11App::Profiler &profiler = X11App::Profiler::instance();
+        if (!profiler.tracing()) {
+            profiler.traceStart();
+            std::cout << "Recording trace, press P again to write it" << std::endl;
+            return;
+        }
+        try {
+            const size_t events = profiler.traceWrite("life-trace.json");
+            std::cout << "Saved life-trace.json: " << events << " zones";
+            if (profiler.traceDropped() > 0) std::cout << ", " << profiler.traceDropped() << " dropped";
+            std::cout << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+#else
+        std::cerr << "Tracing needs a build with -DPROFILING=ON" << std::endl;
+#endif
+    }
+
+    void GameOfLifeApp::simulationUpdateMode() {
+        if (isPaused) simulation.setMode(SimulationMode::Paused);
+        else simulation.setMode(isMaxSpeed ? SimulationMode::MaxSpeed : SimulationMode::Interval);
+    }
+
+    void GameOfLifeApp::simulationUpdateWindow(const int width, const int height) {
+        if (boardBounded) return;
+        const CellRect view = viewport.cellsIn(0, 0, width, height);
+        if (view.width <= 0 || view.height <= 0) return;
+
+        const CellRect &last = simulationWindow;
+        const bool inside = view.x >= last.x && view.y >= last.y && view.x + view.width <= last.x + last.width &&
+                            view.y + view.height <= last.y + last.height;
+        const int64_t viewCells = int64_t{view.width} * view.height;
+        if (inside && int64_t{last.width} * last.height <= 16 * viewCells) return;
+
+        const int windowWidth = std::min(view.width, maxWindowCells / 2) * 2;
+        const int windowHeight = std::min(view.height, maxWindowCells / 2) * 2;
+        simulationWindow = {
+            view.x + view.width / 2 - windowWidth / 2, view.y + view.height / 2 - windowHeight / 2,
+            windowWidth, windowHeight
+        };
+        simulation.setWindow(simulationWindow);
+    }
+
+    CellRect GameOfLifeApp::snapshotBounds() const noexcept {
+        if (snapshot == nullptr) return {0, 0, boardWidth, boardHeight};
+        return {snapshot->originX, snapshot->originY, snapshot->cells.width(), snapshot->cells.height()};
+    }
+
+    void GameOfLifeApp::snapshotAdopt() {
+        // acquire hands the slot of the current snapshot back to the simulation, which may overwrite it right away,
+        // so read everything needed from it first
+        const bool hadSnapshot = snapshot != nullptr;
+        const uint64_t lastSequence = hadSnapshot ? snapshot->sequence : 0;
+        const LifeSnapshot *next = simulation.acquire();
+        if (next == nullptr) return;
+
+        // a skipped snapshot took its changed areas with it
+        const bool complete = hadSnapshot && next->sequence == lastSequence + 1;
+        snapshot = next;
+
+        if (snapshot->cycle.has_value() != hasCycle) {
+            hasCycle = snapshot->cycle.has_value();
+            if (hasCycle) std::cout << "Generation " << snapshot->generation << ": " << snapshot->cycle->toString()
+                                    << std::endl;
+        }
+        // only follow a pause that no command sent since, e.g. the user resuming, can have overridden
+        if (snapshot->pausedOnCycle && snapshot->commands == simulation.commandsSent() && !isPaused) {
+            isPaused = true;
+            windowScheduleRedraw(MAIN_WINDOW, pausedTextArea());
+        }
+        if (deltaRendering && viewport.cellSize >= lodCellSize) {
+            deltaDraw(complete);
+            return;
+        }
+        drawnValid = false;
+        if (!complete || viewport.cellSize < lodCellSize) {
+            windowScheduleRedraw(MAIN_WINDOW);
+            return;
+        }
+
+        const auto attrs = windowGetAttributes(MAIN_WINDOW);
+        for (const auto &area: snapshot->changed) {
+            const XRectangle rect = cellsToScreen(area, attrs.width, attrs.height);
+            if (rect.width != 0 && rect.height != 0) windowScheduleRedraw(MAIN_WINDOW, rect);
+        }
+    }
+
+    void GameOfLifeApp::deltaDraw(const bool complete) {
+        static const auto black = colorCreate(0, 0, 0);
+        static const auto white = colorCreate(65535, 65535, 65535);
+
+        const BitBoard &cells = snapshot->cells;
+        const int originX = snapshot->originX, originY = snapshot->originY;
+        if (!drawnValid || drawnCells.width() != cells.width() || drawnCells.height() != cells.height() ||
+            drawnOriginX != originX || drawnOriginY != originY) {
+            // nothing to compare against, start over from a full redraw
+            drawnCells = cells;
+            drawnOriginX = originX;
+            drawnOriginY = originY;
+            drawnValid = true;
+            windowScheduleRedraw(MAIN_WINDOW);
+            return;
+        }
 
-            if (!isPaused) {
-                const auto currentTime = std::chrono::high_resolution_clock::now();
-                const auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - lastTime).
-                        count();
+        const auto attrs = windowGetAttributes(MAIN_WINDOW);
+        const CellRect bounds = snapshotBounds();
+        const auto [visibleX, visibleY, visibleWidth, visibleHeight] = viewport.cellsIn(
+            0, 0, attrs.width, attrs.height, bounds);
+        const bool gridLines = viewport.cellSize >= gridLineCellSize;
 
-                if (deltaTime >= stepIntervalMs) {
-                    gridStep();
-                    lastTime = currentTime;
+        const std::span<const CellRect> areas = complete ? std::span(snapshot->changed) : std::span(&bounds, 1);
+
+        auto &batch = batchBegin(MAIN_WINDOW);
+        deltaAreas.clear();
+        for (const CellRect &area: areas) {
+            // areas are in engine coordinates, rows and words of the snapshot start at its origin
+            const int areaX = area.x - originX, areaY = area.y - originY;
+            const size_t firstWord = static_cast<size_t>(areaX) / 64;
+            const size_t lastWord = std::min(cells.words(), static_cast<size_t>(areaX + area.width + 63) / 64);
+            deltaBirths.resize(lastWord - firstWord);
+            deltaDeaths.resize(lastWord - firstWord);
+
+            bool drawn = false;
+            for (int row = areaY; row < areaY + area.height; ++row) {
+                const int y = row + originY;
+                const uint64_t *current = cells.row(row);
+                uint64_t *previous = drawnCells.row(row);
+                uint64_t changed = 0;
+                for (size_t i = firstWord; i < lastWord; ++i) {
+                    const uint64_t diff = current[i] ^ previous[i];
+                    deltaBirths[i - firstWord] = diff & current[i];
+                    deltaDeaths[i - firstWord] = diff & ~current[i];
+                    previous[i] = current[i];
+                    changed |= diff;
                 }
+                // rows out of view are kept in sync but not drawn
+                if (changed == 0 || y < visibleY || y >= visibleY + visibleHeight) continue;
+                drawn = true;
+
+                const int top = viewport.screenY(y), bottom = viewport.screenY(y + 1);
+                const auto runs = [&](const std::vector<uint64_t> &words, const XColor &color) {
+                    bitRuns(words.data(), words.size(), [&](int x, int length) {
+                        x += static_cast<int>(firstWord * 64) + originX;
+                        const int first = std::max(x, visibleX);
+                        const int last = std::min(x + length, visibleX + visibleWidth);
+                        if (gridLines) {
+                            for (int cell = first; cell < last; ++cell) {
+                                const int left = viewport.screenX(cell), right = viewport.screenX(cell + 1);
+                                batch.rectangle(color, left, top, right - left - 1, bottom - top - 1);
+                            }
+                        } else if (first < last) {
+                            const int left = viewport.screenX(first), right = viewport.screenX(last);
+                            batch.rectangle(color, left, top, right - left, bottom - top);
+                        }
+                    });
+                };
+                runs(deltaBirths, black);
+                runs(deltaDeaths, white);
             }
 
-            usleep(16000); // ~60 FPS // todo: replace with proper timing mechanism
-            windowProcessRedrawQueue();
+            if (!drawn) continue;
+            const XRectangle rect = cellsToScreen(area, attrs.width, attrs.height);
+            if (rect.width != 0 && rect.height != 0) deltaAreas.push_back(rect);
         }
-    }
+        batchSubmit();
 
+        if (deltaAreas.empty()) return;
+        windowPresent(MAIN_WINDOW, deltaAreas);
+        // cells drawn under the paused text covered parts of it
+        if (isPaused) windowScheduleRedraw(MAIN_WINDOW, pausedTextArea());
+    }
 
     void GameOfLifeApp::handleButtonPress(XButtonEvent &event) {
         const auto winId = windowRawToId(event.window);
         if (!winId.has_value() || !windowCheckOpen(winId.value())) return;
 
-        const auto attrs = windowGetAttributes(winId.value());
-        const int gridX = event.x * gridWidth / attrs.width;
-        const int gridY = event.y * gridHeight / attrs.height;
+        switch (event.button) {
+            case Button1:
+                isDragging = true;
+                hasPanned = false;
+                dragX = event.x;
+                dragY = event.y;
+                break;
+            case Button4:
+            case Button5:
+                viewport.zoomAt(event.x, event.y, event.button == Button4 ? zoomStep : 1 / zoomStep);
+                layerInvalidate(winId.value());
+                break;
+            default: break;
+        }
+    }
+
+    void GameOfLifeApp::handleMotionNotify(XMotionEvent &event) {
+        const auto winId = windowRawToId(event.window);
+        if (!winId.has_value() || !windowCheckOpen(winId.value()) || !isDragging) return;
+
+        if (!hasPanned && std::abs(event.x - dragX) < dragThreshold && std::abs(event.y - dragY) < dragThreshold)
+            return;
+        hasPanned = true;
+        viewport.pan(event.x - dragX, event.y - dragY);
+        dragX = event.x;
+        dragY = event.y;
+        layerInvalidate(winId.value());
+    }
+
+    void GameOfLifeApp::handleButtonRelease(XButtonEvent &event) {
+        const auto winId = windowRawToId(event.window);
+        if (event.button != Button1 || !isDragging) return;
+        isDragging = false;
+        if (hasPanned || !winId.has_value() || !windowCheckOpen(winId.value())) return;
 
-        if (gridX < 0 || gridX >= gridWidth || gridY < 0 || gridY >= gridHeight) return;
+        // a click without dragging toggles the cell under the pointer
+        const int cellX = static_cast<int>(std::floor(viewport.cellX(event.x)));
+        const int cellY = static_cast<int>(std::floor(viewport.cellY(event.y)));
+        if (boardBounded && (cellX < 0 || cellX >= boardWidth || cellY < 0 || cellY >= boardHeight)) return;
 
-        grid[gridX][gridY] = !grid[gridX][gridY];
-        windowScheduleRedraw(winId.value());
+        // the cell is damaged once the simulation publishes the edited board
+        simulation.toggle(cellX, cellY);
     }
 
-    void GameOfLifeApp::gridStep() {
-        static bool newGrid[gridWidth][gridHeight];
-        for (int x = 0; x < gridWidth; ++x) {
-            for (int y = 0; y < gridHeight; ++y) {
-                int liveNeighbors = 0;
-                for (int dx = -1; dx <= 1; ++dx) {
-                    for (int dy = -1; dy <= 1; ++dy) {
-                        if (dx == 0 && dy == 0) continue;
+    XRectangle GameOfLifeApp::cellsToScreen(const CellRect &cells, const int windowWidth,
+                                            const int windowHeight) const {
+        // one extra pixel for the grid line on the right and bottom edge
+        const int left = std::clamp(viewport.screenX(cells.x), 0, windowWidth);
+        const int top = std::clamp(viewport.screenY(cells.y), 0, windowHeight);
+        const int right = std::clamp(viewport.screenX(cells.x + cells.width) + 1, 0, windowWidth);
+        const int bottom = std::clamp(viewport.screenY(cells.y + cells.height) + 1, 0, windowHeight);
+        return {
+            static_cast<short>(left), static_cast<short>(top),
+            static_cast<u16>(right - left), static_cast<u16>(bottom - top)
+        };
+    }
 
-                        const int nx = x + dx;
-                        const int ny = y + dy;
-                        if (nx >= 0 && nx < gridWidth && ny >= 0 && ny < gridHeight)
-                            liveNeighbors += grid[nx][ny] ? 1 : 0;
-                    }
-                }
-                if (grid[x][y]) newGrid[x][y] = (liveNeighbors == 2 || liveNeighbors == 3);
-                else newGrid[x][y] = (liveNeighbors == 3);
+    XRectangle GameOfLifeApp::pausedTextArea() const {
+        const auto extents = textMeasure(defaultFont, pausedText);
+        const int left = std::min(0, extents.lbearing);
+        const int right = std::max(extents.width, extents.rbearing);
+        return {
+            static_cast<short>(pausedTextX + left), static_cast<short>(pausedTextY),
+            static_cast<u16>(right - left), static_cast<u16>(extents.height())
+        };
+    }
+
+    void GameOfLifeApp::drawCells(const int winId, const XRectangle &area) {
+        static const auto black = colorCreate(0, 0, 0);
+
+        if (snapshot == nullptr) return;
+        const BitBoard &cells = snapshot->cells;
+
+        // drawing is clipped to the damaged area, so only the cells intersecting it are worth sending
+        const CellRect bounds = snapshotBounds();
+        const auto [firstX, firstY, width, height] = viewport.cellsIn(area.x, area.y, area.width, area.height,
+                                                                      bounds);
+        const bool gridLines = viewport.cellSize >= gridLineCellSize;
+
+        auto &batch = batchBegin(winId);
+        for (int y = firstY; y < firstY + height; ++y) {
+            const int top = viewport.screenY(y), bottom = viewport.screenY(y + 1);
+            for (int x = firstX; x < firstX + width; ++x) {
+                if (!cells.get(x - bounds.x, y - bounds.y)) continue;
+                const int left = viewport.screenX(x), right = viewport.screenX(x + 1);
+                batch.rectangle(black, left, top, right - left - gridLines, bottom - top - gridLines);
             }
         }
+        batchSubmit();
+    }
+
+    void GameOfLifeApp::drawGrid(const int winId, const unsigned int width, const unsigned int height) {
+        static const auto gray = colorCreate(32000, 32000, 32000);
 
-        std::copy_n(&newGrid[0][0], gridHeight * gridWidth, &grid[0][0]);
-        windowScheduleRedraw(MAIN_WINDOW);
+        if (viewport.cellSize < gridLineCellSize) return;
+        // the lines of an unbounded engine go on across the whole window
+        const int pixelsWide = static_cast<int>(width), pixelsHigh = static_cast<int>(height);
+        const CellRect board{0, 0, boardWidth, boardHeight};
+        const auto [firstX, firstY, cellsWide, cellsHigh] = boardBounded
+            ? viewport.cellsIn(0, 0, pixelsWide, pixelsHigh, board)
+            : viewport.cellsIn(0, 0, pixelsWide, pixelsHigh);
+        const int top = viewport.screenY(firstY), bottom = viewport.screenY(firstY + cellsHigh);
+        const int left = viewport.screenX(firstX), right = viewport.screenX(firstX + cellsWide);
+
+        auto &batch = batchBegin(winId);
+        for (int x = firstX; x <= firstX + cellsWide; ++x)
+            batch.line(gray, viewport.screenX(x), top, viewport.screenX(x), bottom);
+        for (int y = firstY; y <= firstY + cellsHigh; ++y)
+            batch.line(gray, left, viewport.screenY(y), right, viewport.screenY(y));
+        batchSubmit();
+    }
+
+    void GameOfLifeApp::drawDensity(const int winId, const XRectangle &area) {
+        if (snapshot == nullptr) return;
+        const BitBoard &cells = snapshot->cells;
+        const CellRect bounds = snapshotBounds();
+        const auto attrs = windowGetAttributes(winId);
+        const auto image = imageAcquire(winId, attrs.width, attrs.height);
+        const uint32_t outside = imagePack(winId, 200, 200, 200);
+
+        // each pixel samples at most lodSamples x lodSamples cells of its footprint, which keeps the cost
+        // proportional to the window size however far out the view is zoomed
+        constexpr int lodSamples = 4;
+        const double footprint = 1 / viewport.cellSize;
+        const int samples = std::clamp(static_cast<int>(std::ceil(footprint)), 1, lodSamples);
+        const double spacing = footprint / samples;
+
+        uint32_t shades[lodSamples * lodSamples + 1];
+        for (int live = 0; live <= samples * samples; ++live) {
+            const auto level = static_cast<uint8_t>(255 - live * 255 / (samples * samples));
+            shades[live] = imagePack(winId, level, level, level);
+        }
+
+        const int right = std::min<int>(area.x + area.width, static_cast<int>(image.width));
+        const int bottom = std::min<int>(area.y + area.height, static_cast<int>(image.height));
+        for (int py = std::max<int>(area.y, 0); py < bottom; ++py) {
+            const double cellTop = viewport.cellY(py);
+            for (int px = std::max<int>(area.x, 0); px < right; ++px) {
+                const double cellLeft = viewport.cellX(px);
+                if (cellLeft < bounds.x || cellTop < bounds.y || cellLeft >= bounds.x + bounds.width ||
+                    cellTop >= bounds.y + bounds.height) {
+                    image.at(px, py) = outside;
+                    continue;
+                }
+
+                int live = 0;
+                for (int sy = 0; sy < samples; ++sy)
+                    for (int sx = 0; sx < samples; ++sx)
+                        live += cells.get(static_cast<int>(std::floor(cellLeft + sx * spacing)) - bounds.x,
+                                          static_cast<int>(std::floor(cellTop + sy * spacing)) - bounds.y);
+                image.at(px, py) = shades[live];
+            }
+        }
+        imagePresent(winId, 0, 0);
     }
 
     void GameOfLifeApp::handleExpose(XExposeEvent &event) {
-        if (event.count != 0) return;
         const auto eventWinId = windowRawToId(event.window);
         if (!eventWinId.has_value() || !windowCheckOpen(eventWinId.value())) return;
 
         const auto winId = eventWinId.value();
 
-        static const auto gray = colorCreate(32000, 32000, 32000);
         static const auto black = colorCreate(0, 0, 0);
 
         switch (winId) {
             case MAIN_WINDOW: {
-                const auto attrs = windowGetAttributes(winId);
-                const int cellWidth = attrs.width / gridWidth;
-                const int cellHeight = attrs.height / gridHeight;
-
-                for (int x = 0; x < gridWidth; ++x) {
-                    for (int y = 0; y < gridHeight; ++y) {
-                        if (grid[x][y])
-                            drawRectangle(winId, black, x * cellWidth, y * cellHeight,
-                                          cellWidth - 1, cellHeight - 1);
-                    }
-                }
-
-                // Draw grid lines
-                for (int x = 0; x <= gridWidth; ++x)
-                    drawLine(winId, gray, x * cellWidth, 0, x * cellWidth, attrs.height - 1);
-
-                for (int y = 0; y <= gridHeight; ++y)
-                    drawLine(winId, gray, 0, y * cellHeight, attrs.width - 1, y * cellHeight);
+                const XRectangle area{
+                    static_cast<short>(event.x), static_cast<short>(event.y),
+                    static_cast<u16>(event.width), static_cast<u16>(event.height)
+                };
+                if (viewport.cellSize < lodCellSize) drawDensity(winId, area);
+                else drawCells(winId, area);
 
                 // Draw paused text
                 if (isPaused) {
-                    const static std::string text = "PAUSED";
-                    drawText(winId, black, 10, 20, defaultFont, text);
+                    const auto extents = textMeasure(defaultFont, pausedText);
+                    drawText(winId, black, pausedTextX, pausedTextY + extents.ascent, defaultFont, pausedText);
                 }
             }
 
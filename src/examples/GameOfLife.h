@@ -5,8 +5,18 @@
 #ifndef X11TEST_TESTAPP_H
 #define X11TEST_TESTAPP_H
 
+#include <iostream>
+#include <optional>
+#include <utility>
+
 #include "../../core/App.h"
 #include "../../core/lib/EventMask.h"
+#include "../../core/lib/WorkStealingPool.h"
+#include "life/Checkpoint.h"
+#include "life/Engines.h"
+#include "life/PatternIO.h"
+#include "life/Simulation.h"
+#include "life/Viewport.h"
 
 
 namespace GameOfLife {
@@ -14,33 +24,165 @@ namespace GameOfLife {
         MAIN_WINDOW = 1
     };
 
-    constexpr int gridWidth = 20;
-    constexpr int gridHeight = 20;
     constexpr int stepIntervalMs = 250;
+    constexpr double zoomStep = 1.25; // per mouse wheel notch
+    constexpr double lodCellSize = 2; // below this many pixels per cell, cells are drawn as density pixels
+    constexpr double gridLineCellSize = 6; // grid lines are only drawn for cells at least this large
+    constexpr int dragThreshold = 4; // pixels the pointer has to move before a press pans instead of toggling
+    /// Most cells across and down snapshotted of an unbounded engine, views wider than that show the cells around
+    /// their centre.
+    constexpr int maxWindowCells = 4096;
+    /// Most cells a checkpoint of an unbounded engine copies, 512 MiB, the live cells may have spread much further.
+    constexpr uint64_t maxCheckpointCells = uint64_t{1} << 32;
+    /// Largest generations per step as a power of two. Bounded engines pay per generation, unbounded ones per jump.
+    constexpr int maxBoundedStepLog2 = 10;
+    constexpr int maxUnboundedStepLog2 = 48;
+    constexpr uint64_t fastForwardGenerations = 1024; // per press of F
+    constexpr std::string_view pausedText = "PAUSED";
+    constexpr PixelPos pausedTextX = 10;
+    constexpr PixelPos pausedTextY = 10;
 
     class GameOfLifeApp final : public X11App::App {
         friend App;
 
-        bool grid[gridWidth][gridHeight];
-        bool running;
+        X11App::WorkStealingPool pool; // declared before engine, which steps on it
+        std::unique_ptr<LifeEngine> engine; // only touched by the simulation thread once it runs
+        CheckpointWriter checkpoints{}; // declared before simulation, whose thread submits to it
+        Simulation simulation;
+        const LifeSnapshot *snapshot = nullptr; // the board being displayed
+        const int boardWidth, boardHeight;
+        const bool boardBounded;
+        const LifeRule boardRule;
+        const std::string checkpointPath;
+        CellRect home{}; // the area Home fits into the window
         bool isPaused;
+        bool hasCycle = false; // the displayed board is known to repeat
+        bool deltaRendering = true; // D toggles between drawing changed cells in place and redrawing damaged areas
+        BitBoard drawnCells{}; // the cells on screen once pending redraws are done, while drawnValid
+        int drawnOriginX = 0, drawnOriginY = 0; // LifeSnapshot::originX/Y of drawnCells
+        bool drawnValid = false;
+        CellRect simulationWindow{}; // the window last sent to the simulation of an unbounded engine
+        std::vector<uint64_t> deltaBirths{}, deltaDeaths{}; // scratch of deltaDraw, one row of an area
+        std::vector<XRectangle> deltaAreas{}; // scratch of deltaDraw, what to present
+        bool isMaxSpeed = false;
+        int stepLog2 = 0; // each step advances 2^stepLog2 generations, changed with the arrow keys
+
+        Viewport viewport{};
+        bool isDragging = false, hasPanned = false;
+        int dragX = 0, dragY = 0; // pointer position of the press, then of the last pan
 
         std::vector<XPoint> polygonPoints;
         const long defaultMask;
         const std::string defaultFont;
 
-        explicit GameOfLifeApp(Display *display)
-            : App(display), running(true), isPaused(true), polygonPoints({}), defaultMask(
+        /// @param display The display connection.
+        /// @param engineConfig Which engine to simulate with and the board dimensions.
+        /// @param threads Workers of the stepping pool including the main thread, 0 for one per hardware thread.
+        /// @param loadPath A checkpoint to resume or a pattern file to load centred on the board, empty for an empty
+        /// board.
+        /// @param loadPeek The patternPeek of a pattern file at loadPath, if the caller has one, so it is not read
+        /// again.
+        /// @param checkpointPath Where C saves a checkpoint.
+        /// @param onCycle What the simulation does once the board settles into a still life or oscillator.
+        /// @throws std::runtime_error if the file cannot be loaded.
+        explicit GameOfLifeApp(Display *display, const EngineConfig &engineConfig = {}, const unsigned threads = 0,
+                               const std::string &loadPath = {},
+                               const std::optional<PatternStats> &loadPeek = std::nullopt,
+                               std::string checkpointPath = "life.ckpt",
+                               const CycleAction onCycle = CycleAction::Report)
+            : App(display), pool(threads), engine(engineCreateOn(engineConfig, pool)),
+              simulation(*engine, std::chrono::milliseconds(stepIntervalMs), [this] { frameWake(); },
+                         [this](const LifeEngine &simulated) { checkpointCapture(simulated); }),
+              boardWidth(engine->width()), boardHeight(engine->height()), boardBounded(engine->bounded()),
+              boardRule(engine->rule()), checkpointPath(std::move(checkpointPath)), isPaused(true),
+              polygonPoints({}), defaultMask(
                   X11App::EventMask().useExposureMask().useKeyPressMask().useKeyReleaseMask().
-                  useButtonPressMask().mask), defaultFont(X11App::FontDescriptor("helvetica", 150).toString()) {
-            std::fill_n(&grid[0][0], gridWidth * gridHeight, false);
+                  useButtonPressMask().useButtonReleaseMask().useButton1MotionMask().mask),
+              defaultFont(X11App::FontDescriptor("helvetica", 150).toString()) {
+            // the simulation thread is not running yet, so the engine can still be written from here
+            if (!loadPath.empty()) std::cout << boardLoad(*engine, loadPath, loadPeek) << std::endl;
+            // a restored unbounded engine may have its cells anywhere, show them along with the board
+            home = {0, 0, boardWidth, boardHeight};
+            if (!boardBounded) {
+                const CellRect live = engine->extent();
+                const int left = std::min(home.x, live.x), top = std::min(home.y, live.y);
+                home.width = std::max(home.x + home.width, live.x + live.width) - left;
+                home.height = std::max(home.y + home.height, live.y + live.height) - top;
+                home.x = left;
+                home.y = top;
+            }
+            simulation.setCycleAction(onCycle);
+        }
+
+        static std::unique_ptr<LifeEngine> engineCreateOn(EngineConfig config, X11App::WorkStealingPool &pool) {
+            config.pool = &pool;
+            return engineCreate(config);
         }
 
         void handleExpose(XExposeEvent &event) override;
 
         void handleButtonPress(XButtonEvent &event) override;
 
-        void gridStep();
+        void handleButtonRelease(XButtonEvent &event) override;
+
+        void handleMotionNotify(XMotionEvent &event) override;
+
+        void frameUpdate() override;
+
+        /// @return The area covered by the paused text, so toggling pause only redraws that part of the window.
+        [[nodiscard]] XRectangle pausedTextArea() const;
+
+        /// Write the displayed board to life-<generation>.rle in the working directory. Of an unbounded engine that
+        /// is the window snapshotted around the view.
+        void snapshotSave() const;
+
+        /// Hand a copy of the displayed board to the checkpoint writer. Snapshots of unbounded engines only hold the
+        /// window in view, so those are captured by the simulation instead.
+        void snapshotCheckpoint();
+
+        /// Simulation thread. Hand a copy of all live cells of an unbounded engine to the checkpoint writer.
+        void checkpointCapture(const LifeEngine &simulated);
+
+        /// Start recording a profiler trace, or write the one being recorded to life-trace.json.
+        void traceToggle();
+
+        /// Send the current pause/speed state to the simulation.
+        void simulationUpdateMode();
+
+        /// Send the cells in view of a window of the given size, with a margin of half the view on every side, to
+        /// the simulation of an unbounded engine. Sent again only once the view leaves the last window or needs far
+        /// fewer cells than it.
+        void simulationUpdateWindow(int width, int height);
+
+        /// @return The cells the displayed snapshot holds, the board of a bounded engine.
+        [[nodiscard]] CellRect snapshotBounds() const noexcept;
+
+        /// Display the newest snapshot of the simulation, if there is one, and damage what changed. Follows the
+        /// simulation when it paused itself on a cycle.
+        void snapshotAdopt();
+
+        /**
+         * Bring the window up to date with the adopted snapshot without clearing it: XOR the snapshot with the cells
+         * drawn before, within the areas that changed, and fill each horizontal run of births in the cell colour and
+         * of deaths in the background colour. With grid lines, runs are split into cells to keep the lines intact.
+         * @param complete False if snapshots were skipped, their changed areas are lost and the whole board is
+         * compared then.
+         */
+        void deltaDraw(bool complete);
+
+        /// Draw the cells in the area one rectangle per live cell, leaving a gap for the grid lines of the layer when
+        /// zoomed in far enough.
+        void drawCells(int winId, const XRectangle &area);
+
+        /// Render the static layer of the window: the grid lines of the visible cells when zoomed in far enough.
+        /// Rendered again only when the window is resized or the view changes.
+        void drawGrid(int winId, unsigned int width, unsigned int height);
+
+        /// Draw the area as one pixel per window pixel, shaded by the share of live cells it covers.
+        void drawDensity(int winId, const XRectangle &area);
+
+        /// @return The pixels covered by the cells, clipped to the window size.
+        [[nodiscard]] XRectangle cellsToScreen(const CellRect &cells, int windowWidth, int windowHeight) const;
     public:
         void run() override;
     };
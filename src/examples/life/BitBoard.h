@@ -0,0 +1,120 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BITBOARD_H
+#define X11TEST_BITBOARD_H
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace GameOfLife {
+    /// Call fn(x, length) for every run of set bits in count words, bit x % 64 of word x / 64.
+    template<typename Fn>
+    void bitRuns(const uint64_t *words, const size_t count, Fn &&fn) {
+        const size_t end = count * 64;
+        for (size_t x = 0; x < end;) {
+            size_t i = x / 64;
+            uint64_t word = words[i] & ~0ull << (x % 64);
+            while (word == 0 && ++i < count) word = words[i];
+            if (word == 0) return;
+            const size_t start = i * 64 + std::countr_zero(word);
+
+            i = start / 64;
+            word = ~words[i] & ~0ull << (start % 64);
+            while (word == 0 && ++i < count) word = ~words[i];
+            const size_t stop = word == 0 ? end : i * 64 + std::countr_zero(word);
+            fn(static_cast<int>(start), static_cast<int>(stop - start));
+            x = stop;
+        }
+    }
+
+    /**
+     * Bit-packed board, 64 cells per word, row major. Cell x of a row is bit x % 64 of word x / 64.
+     *
+     * Every row has a zero guard word on both sides and the board has a zero guard row above and below,
+     * so kernels can read the neighbours of any cell without bounds checks. Bits past the width in the last word
+     * of a row are kept zero as well.
+     */
+    class BitBoard {
+        int m_Width = 0, m_Height = 0;
+        size_t m_Words = 0; // payload words per row
+        size_t m_Stride = 0; // words per row including both guard words
+        uint64_t m_TailMask = 0; // valid bits of the last payload word
+        std::vector<uint64_t> m_Data{};
+
+    public:
+        BitBoard() = default;
+
+        BitBoard(const int width, const int height) : m_Width(width), m_Height(height) {
+            if (width <= 0 || height <= 0) throw std::invalid_argument("Board dimensions must be positive");
+            m_Words = (static_cast<size_t>(width) + 63) / 64;
+            m_Stride = m_Words + 2;
+            m_TailMask = width % 64 == 0 ? ~0ull : (1ull << (width % 64)) - 1;
+            m_Data.assign(m_Stride * (static_cast<size_t>(height) + 2), 0);
+        }
+
+        [[nodiscard]] int width() const noexcept { return m_Width; }
+        [[nodiscard]] int height() const noexcept { return m_Height; }
+        [[nodiscard]] size_t words() const noexcept { return m_Words; }
+        [[nodiscard]] size_t stride() const noexcept { return m_Stride; }
+        [[nodiscard]] uint64_t tailMask() const noexcept { return m_TailMask; }
+
+        /// @param y Row index, -1 and height() address the guard rows.
+        /// @return Pointer to the first payload word of the row, index -1 and words() are the guard words.
+        [[nodiscard]] uint64_t *row(const int y) noexcept { return m_Data.data() + (y + 1) * m_Stride + 1; }
+
+        [[nodiscard]] const uint64_t *row(const int y) const noexcept {
+            return m_Data.data() + (y + 1) * m_Stride + 1;
+        }
+
+        [[nodiscard]] bool inBounds(const int x, const int y) const noexcept {
+            return x >= 0 && x < m_Width && y >= 0 && y < m_Height;
+        }
+
+        [[nodiscard]] bool get(const int x, const int y) const noexcept {
+            if (!inBounds(x, y)) return false;
+            return row(y)[x / 64] >> (x % 64) & 1;
+        }
+
+        void set(const int x, const int y, const bool alive) noexcept {
+            if (!inBounds(x, y)) return;
+            uint64_t &word = row(y)[x / 64];
+            const uint64_t bit = 1ull << (x % 64);
+            word = alive ? word | bit : word & ~bit;
+        }
+
+        /// Set length cells along row y starting at x, clipped to the board.
+        void setSpan(int x, const int y, int length, const bool alive) noexcept {
+            if (y < 0 || y >= m_Height) return;
+            if (x < 0) {
+                length += x;
+                x = 0;
+            }
+            length = std::min(length, m_Width - x);
+            uint64_t *words = row(y);
+            for (const int end = x + length; x < end;) {
+                const int bit = x % 64, count = std::min(64 - bit, end - x);
+                const uint64_t mask = (count == 64 ? ~0ull : (1ull << count) - 1) << bit;
+                uint64_t &word = words[x / 64];
+                word = alive ? word | mask : word & ~mask;
+                x += count;
+            }
+        }
+
+        void clear() noexcept { std::ranges::fill(m_Data, 0); }
+
+        /// @return The number of live cells.
+        [[nodiscard]] uint64_t population() const noexcept {
+            uint64_t count = 0;
+            for (const uint64_t word: m_Data) count += std::popcount(word);
+            return count;
+        }
+
+        bool operator==(const BitBoard &other) const noexcept = default;
+    };
+}
+
+#endif //X11TEST_BITBOARD_H
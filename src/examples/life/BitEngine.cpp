@@ -0,0 +1,167 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "BitEngine.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace GameOfLife {
+    BitEngine::BitEngine(const int width, const int height, const Kernel kernel, X11App::WorkStealingPool *pool,
+                         const LifeRule &rule)
+        : m_Current(width, height), m_Next(width, height), m_Rule(rule), m_Kernel(kernelResolve(kernel)),
+          m_Stepper(nullptr), m_Pool(pool),
+          m_TilesX(static_cast<int>((m_Current.words() + tileWords - 1) / tileWords)),
+          m_TilesY((height + tileRows - 1) / tileRows) {
+        if (!rule.lifeLike())
+            throw std::invalid_argument("The bits engine only supports Life-like rules, not " + rule.toString());
+        m_Stepper = kernelStepper(m_Kernel, m_Rule);
+        m_Changed.assign(tileCount(), m_Rule.birth & 1);
+        m_NextChanged.assign(tileCount(), 0);
+        m_Dirty.assign(tileCount(), 0);
+        m_Active.reserve(tileCount());
+        m_TileHash.assign(tileCount(), 0);
+        m_NextTileHash.assign(tileCount(), 0);
+        m_HashStale.assign(tileCount(), 0);
+        m_TileStats.total = tileCount();
+    }
+
+    int BitEngine::tileOf(const int x, const int y) const noexcept {
+        return y / tileRows * m_TilesX + x / static_cast<int>(tileWords * 64);
+    }
+
+    uint64_t BitEngine::tileHash(const BitBoard &board, const uint32_t tile) const noexcept {
+        const int tileX = static_cast<int>(tile) % m_TilesX, tileY = static_cast<int>(tile) / m_TilesX;
+        const int firstRow = tileY * tileRows;
+        const size_t firstWord = static_cast<size_t>(tileX) * tileWords;
+        return boardHash(board, firstRow, std::min(firstRow + tileRows, board.height()), firstWord,
+                         std::min(firstWord + tileWords, board.words()));
+    }
+
+    void BitEngine::touch(const int tile) noexcept {
+        // the back board no longer matches this tile, so it has to be stepped
+        m_Changed[tile] = 1;
+        m_Dirty[tile] = 1;
+        m_HashStale[tile] = 1;
+        m_AnyHashStale = true;
+    }
+
+    void BitEngine::set(const int x, const int y, const bool alive) noexcept {
+        if (!m_Current.inBounds(x, y) || m_Current.get(x, y) == alive) return;
+        m_Current.set(x, y, alive);
+        touch(tileOf(x, y));
+    }
+
+    void BitEngine::setSpan(int x, const int y, int length, const bool alive) noexcept {
+        if (y < 0 || y >= height()) return;
+        if (x < 0) {
+            length += x;
+            x = 0;
+        }
+        length = std::min(length, width() - x);
+        if (length <= 0) return;
+        m_Current.setSpan(x, y, length, alive);
+        for (int tile = tileOf(x, y); tile <= tileOf(x + length - 1, y); ++tile) touch(tile);
+    }
+
+    void BitEngine::clear() noexcept {
+        // both boards must agree on every tile that is not marked as changed, and an empty tile only stays empty
+        // without birth on 0 neighbours
+        m_Current.clear();
+        m_Next.clear();
+        std::ranges::fill(m_Changed, m_Rule.birth & 1);
+        std::ranges::fill(m_Dirty, 1);
+        std::ranges::fill(m_TileHash, 0);
+        std::ranges::fill(m_HashStale, 0);
+        m_AnyHashStale = false;
+        m_Hash = 0;
+        m_Generation = 0;
+    }
+
+    void BitEngine::step() {
+        // a tile has to be stepped if it or one of its 8 neighbours changed in the last generation
+        m_Active.clear();
+        for (int tileY = 0; tileY < m_TilesY; ++tileY) {
+            for (int tileX = 0; tileX < m_TilesX; ++tileX) {
+                bool active = false;
+                for (int y = std::max(0, tileY - 1); !active && y <= std::min(m_TilesY - 1, tileY + 1); ++y)
+                    for (int x = std::max(0, tileX - 1); !active && x <= std::min(m_TilesX - 1, tileX + 1); ++x)
+                        active = m_Changed[y * m_TilesX + x];
+                if (active) m_Active.push_back(static_cast<uint32_t>(tileY * m_TilesX + tileX));
+            }
+        }
+
+        std::ranges::fill(m_NextChanged, 0);
+        const auto stepTile = [this](const size_t index) {
+            const uint32_t tile = m_Active[index];
+            const int tileX = static_cast<int>(tile) % m_TilesX, tileY = static_cast<int>(tile) / m_TilesX;
+            const int firstRow = tileY * tileRows;
+            const size_t firstWord = static_cast<size_t>(tileX) * tileWords;
+            m_NextChanged[tile] = m_Stepper(m_Current, m_Next, firstRow,
+                                            std::min(firstRow + tileRows, m_Current.height()), firstWord,
+                                            std::min(firstWord + tileWords, m_Current.words()), m_Rule);
+            // an unchanged tile keeps its hash, unless it was edited after it was last hashed
+            if (m_NextChanged[tile] || m_HashStale[tile]) m_NextTileHash[tile] = tileHash(m_Next, tile);
+        };
+        if (m_Pool != nullptr) m_Pool->parallelFor(m_Active.size(), stepTile);
+        else for (size_t i = 0; i < m_Active.size(); ++i) stepTile(i);
+
+        std::swap(m_Current, m_Next);
+        m_Changed.swap(m_NextChanged);
+        m_Generation++;
+
+        m_TileStats.active = static_cast<int>(m_Active.size());
+        m_TileStats.changed = 0;
+        for (const uint32_t tile: m_Active) {
+            if (m_Changed[tile] || m_HashStale[tile]) {
+                m_Hash ^= m_TileHash[tile] ^ m_NextTileHash[tile];
+                m_TileHash[tile] = m_NextTileHash[tile];
+                m_HashStale[tile] = 0;
+            }
+            if (!m_Changed[tile]) continue;
+            m_TileStats.changed++;
+            m_Dirty[tile] = 1;
+        }
+        // edited tiles are marked as changed, so all of them were active
+        m_AnyHashStale = false;
+        m_TileStats.activeSum += m_Active.size();
+        m_TileStats.totalSum += tileCount();
+    }
+
+    uint64_t BitEngine::hash() {
+        // edited tiles are rehashed by the next step anyway, this only catches up on those edited since
+        if (m_AnyHashStale) {
+            for (uint32_t tile = 0; tile < m_HashStale.size(); ++tile) {
+                if (!m_HashStale[tile]) continue;
+                const uint64_t hash = tileHash(m_Current, tile);
+                m_Hash ^= m_TileHash[tile] ^ hash;
+                m_TileHash[tile] = hash;
+                m_HashStale[tile] = 0;
+            }
+            m_AnyHashStale = false;
+        }
+        return m_Hash;
+    }
+
+    void BitEngine::takeChangedAreas(std::vector<CellRect> &out) {
+        constexpr int tileCells = static_cast<int>(tileWords * 64);
+        for (int tileY = 0; tileY < m_TilesY; ++tileY) {
+            // one rectangle per horizontal run of dirty tiles
+            for (int tileX = 0; tileX < m_TilesX;) {
+                if (!m_Dirty[tileY * m_TilesX + tileX]) {
+                    tileX++;
+                    continue;
+                }
+                const int first = tileX;
+                while (tileX < m_TilesX && m_Dirty[tileY * m_TilesX + tileX]) m_Dirty[tileY * m_TilesX + tileX++] = 0;
+
+                const int x = first * tileCells, y = tileY * tileRows;
+                out.push_back({
+                    x, y, std::min(tileX * tileCells, width()) - x, std::min(y + tileRows, height()) - y
+                });
+            }
+        }
+    }
+}
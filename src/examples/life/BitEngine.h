@@ -0,0 +1,119 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BITENGINE_H
+#define X11TEST_BITENGINE_H
+#include <vector>
+
+#include "../../../core/lib/WorkStealingPool.h"
+#include "BitBoard.h"
+#include "BitKernel.h"
+#include "LifeEngine.h"
+
+namespace GameOfLife {
+    /// Tile counts of the last generation of a BitEngine.
+    struct TileStats {
+        int total = 0;
+        int active = 0; // tiles that were stepped
+        int changed = 0; // stepped tiles whose cells changed
+        uint64_t activeSum = 0; // active tiles summed over all generations
+        uint64_t totalSum = 0;
+    };
+
+    /**
+     * Engine on a bit-packed board, stepping 64 cells per word operation (256/512 with AVX2/AVX-512).
+     *
+     * Each generation is split into tiles of tileRows x tileWords words, stepped concurrently if there is a pool.
+     * A tile reads its halo rows and words straight from the current board, which no one writes during the step.
+     *
+     * Only tiles that changed in the last generation or border such a tile are stepped. A skipped tile is stable,
+     * so the generation before it, still held by the back board, already equals the next one. This holds for every
+     * rule, but with birth on 0 neighbours an empty board is not stable, so all tiles then start out as changed.
+     *
+     * The hash of every tile is kept up to date the same way: tiles that changed are rehashed by the task that
+     * stepped them, and the board hash is patched with the difference.
+     */
+    class BitEngine final : public LifeEngine {
+        BitBoard m_Current, m_Next;
+        LifeRule m_Rule;
+        Kernel m_Kernel;
+        TileStepper m_Stepper;
+        uint64_t m_Generation = 0;
+        X11App::WorkStealingPool *m_Pool;
+        int m_TilesX, m_TilesY;
+        std::vector<uint8_t> m_Changed{}, m_NextChanged{}; // per tile, changed in the last generation
+        std::vector<uint8_t> m_Dirty{}; // per tile, changed since the last takeChangedAreas
+        std::vector<uint32_t> m_Active{}; // tiles stepped this generation
+        std::vector<uint64_t> m_TileHash{}, m_NextTileHash{}; // per tile, boardHash of its words
+        std::vector<uint8_t> m_HashStale{}; // per tile, set since its hash was computed
+        bool m_AnyHashStale = false;
+        uint64_t m_Hash = 0; // XOR of m_TileHash
+        TileStats m_TileStats{};
+
+        [[nodiscard]] int tileOf(int x, int y) const noexcept;
+
+        [[nodiscard]] uint64_t tileHash(const BitBoard &board, uint32_t tile) const noexcept;
+
+        /// Mark the tile as edited, so it is stepped and hashed again.
+        void touch(int tile) noexcept;
+
+    public:
+        /// @param width The width of the board in cells.
+        /// @param height The height of the board in cells.
+        /// @param kernel The kernel to step with. Unsupported kernels fall back to the next slower one.
+        /// @param pool The pool to step tiles on, not owned. nullptr steps on the calling thread.
+        /// @param rule A Life-like rule.
+        /// @throws std::invalid_argument if the rule has more than 2 states or a larger neighbourhood.
+        BitEngine(int width, int height, Kernel kernel = Kernel::Auto, X11App::WorkStealingPool *pool = nullptr,
+                  const LifeRule &rule = {});
+
+        /// Rows of a tile. Small enough that stable regions are skipped at a fine grain, big enough that a tile
+        /// (4 KiB per board) amortises the cost of scheduling it on the pool.
+        static constexpr int tileRows = 64;
+        /// Words of a tile row, 512 cells.
+        static constexpr size_t tileWords = 8;
+
+        [[nodiscard]] const char *name() const noexcept override { return "bits"; }
+        [[nodiscard]] LifeRule rule() const noexcept override { return m_Rule; }
+        [[nodiscard]] int width() const noexcept override { return m_Current.width(); }
+        [[nodiscard]] int height() const noexcept override { return m_Current.height(); }
+        [[nodiscard]] uint64_t generation() const noexcept override { return m_Generation; }
+        void setGeneration(const uint64_t generation) noexcept override { m_Generation = generation; }
+
+        [[nodiscard]] bool get(const int x, const int y) const noexcept override { return m_Current.get(x, y); }
+
+        void set(int x, int y, bool alive) noexcept override;
+
+        void setSpan(int x, int y, int length, bool alive) noexcept override;
+
+        void clear() noexcept override;
+
+        void step() override;
+
+        void takeChangedAreas(std::vector<CellRect> &out) override;
+
+        /// Only rehashes the tiles that changed in the last generation or were edited since.
+        [[nodiscard]] uint64_t hash() override;
+
+        /// Copies the board, reusing the memory of out if it has the same dimensions.
+        void snapshot(BitBoard &out) const override { out = m_Current; }
+
+        /// @return The kernel actually used after resolving Auto and unsupported kernels.
+        [[nodiscard]] Kernel kernel() const noexcept { return m_Kernel; }
+
+        void setKernel(const Kernel kernel) noexcept {
+            m_Kernel = kernelResolve(kernel);
+            m_Stepper = kernelStepper(m_Kernel, m_Rule);
+        }
+
+        [[nodiscard]] const BitBoard &board() const noexcept { return m_Current; }
+
+        /// @return The number of tiles a generation is split into.
+        [[nodiscard]] int tileCount() const noexcept { return m_TilesX * m_TilesY; }
+
+        [[nodiscard]] const TileStats &tileStats() const noexcept { return m_TileStats; }
+    };
+}
+
+#endif //X11TEST_BITENGINE_H
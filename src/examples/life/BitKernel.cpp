@@ -0,0 +1,292 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "BitKernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if LIFE_SIMD && defined(__x86_64__)
+#define LIFE_X86_SIMD 1
+#else
+#define LIFE_X86_SIMD 0
+#endif
+
+// The helpers below are always inlined into the target specific functions, so the ABI of passing wide vectors
+// to non inlined functions compiled without AVX never comes into play.
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+namespace GameOfLife {
+    namespace {
+        // GCC vector extensions compile to plain 64 bit operations, AVX2 or AVX-512 depending on the target
+        // attribute of the function they are inlined into
+        using Vec4 = uint64_t __attribute__((vector_size(32)));
+        using Vec8 = uint64_t __attribute__((vector_size(64)));
+
+        template<typename V>
+        [[gnu::always_inline]] inline V load(const uint64_t *p) noexcept {
+            V v;
+            std::memcpy(&v, p, sizeof(V));
+            return v;
+        }
+
+        template<typename V>
+        [[gnu::always_inline]] inline void store(uint64_t *p, const V &v) noexcept { std::memcpy(p, &v, sizeof(V)); }
+
+        template<typename V>
+        [[gnu::always_inline]] inline void fullAdd(const V &a, const V &b, const V &c, V &sum, V &carry) noexcept {
+            const V t = a ^ b;
+            sum = t ^ c;
+            carry = (a & b) | (t & c);
+        }
+
+        /// The 8 neighbours of the words at up/mid/down (the rows above, at and below the computed row) summed with
+        /// a bit-sliced adder: bit n of count holds bit n of the neighbour count of every cell. The neighbours are
+        /// the row words shifted by one cell, with the bit crossing the word boundary taken from the adjacent word.
+        template<typename V>
+        struct Counts {
+            V alive, count0, count1, count2, count3;
+        };
+
+        /// @tparam Eight Compute count3. Without it a count of 8 wraps to 0, which is fine for rules that treat
+        /// both the same.
+        template<typename V, bool Eight>
+        [[gnu::always_inline]] inline Counts<V> neighbourCounts(const uint64_t *up, const uint64_t *mid,
+                                                                const uint64_t *down) noexcept {
+            const V u = load<V>(up), m = load<V>(mid), d = load<V>(down);
+            const V uL = (u << 1) | (load<V>(up - 1) >> 63), uR = (u >> 1) | (load<V>(up + 1) << 63);
+            const V mL = (m << 1) | (load<V>(mid - 1) >> 63), mR = (m >> 1) | (load<V>(mid + 1) << 63);
+            const V dL = (d << 1) | (load<V>(down - 1) >> 63), dR = (d >> 1) | (load<V>(down + 1) << 63);
+
+            V upOnes, upTwos, downOnes, downTwos;
+            fullAdd(uL, u, uR, upOnes, upTwos);
+            fullAdd(dL, d, dR, downOnes, downTwos);
+            const V midOnes = mL ^ mR, midTwos = mL & mR;
+
+            Counts<V> counts{m, {}, {}, {}, {}};
+            V carryTwos;
+            fullAdd(upOnes, downOnes, midOnes, counts.count0, carryTwos);
+            V twos, fours;
+            fullAdd(upTwos, downTwos, midTwos, twos, fours);
+            counts.count1 = twos ^ carryTwos;
+            counts.count2 = fours ^ (twos & carryTwos);
+            if constexpr (Eight) counts.count3 = fours & twos & carryTwos;
+            return counts;
+        }
+
+        /// @return Bits set for the cells with exactly count neighbours, count is a constant after inlining.
+        template<typename V, bool Eight>
+        [[gnu::always_inline]] inline V countIs(const Counts<V> &counts, const int count) noexcept {
+            V is = count & 1 ? counts.count0 : ~counts.count0;
+            is &= count & 2 ? counts.count1 : ~counts.count1;
+            is &= count & 4 ? counts.count2 : ~counts.count2;
+            if constexpr (Eight) is &= count & 8 ? counts.count3 : ~counts.count3;
+            return is;
+        }
+
+        /// Next state for a rule known at compile time. The checks of the counts not in the rule are dropped
+        /// before code generation, so each rule compiles to its own minimal bit logic.
+        template<uint64_t Birth, uint64_t Survive>
+        struct StaticNext {
+            // 8 only needs its own bit if the rule tells it apart from 0
+            static constexpr bool eight = (Birth & 1) != (Birth >> 8 & 1) || (Survive & 1) != (Survive >> 8 & 1);
+
+            static StaticNext make(const LifeRule &) noexcept { return {}; }
+
+            template<typename V>
+            [[gnu::always_inline]] V next(const uint64_t *up, const uint64_t *mid, const uint64_t *down) const noexcept {
+                const Counts<V> counts = neighbourCounts<V, eight>(up, mid, down);
+                if constexpr (Birth == countMask("3") && Survive == countMask("23")) {
+                    // Conway's rule: count == 3, or count == 2 and alive now
+                    return counts.count1 & ~counts.count2 & (counts.count0 | counts.alive);
+                } else {
+                    V born{}, survives{};
+                    [&]<int... Count>(std::integer_sequence<int, Count...>) {
+                        ((Birth >> Count & 1 ? void(born |= countIs<V, eight>(counts, Count)) : void()), ...);
+                        ((Survive >> Count & 1 ? void(survives |= countIs<V, eight>(counts, Count)) : void()), ...);
+                    }(std::make_integer_sequence<int, eight ? 9 : 8>{});
+                    return (born & ~counts.alive) | (survives & counts.alive);
+                }
+            }
+        };
+
+        /// Next state for any Life-like rule, testing the counts in the rule one by one.
+        struct RuntimeNext {
+            uint64_t birth, survive;
+
+            static RuntimeNext make(const LifeRule &rule) noexcept { return {rule.birth, rule.survive}; }
+
+            template<typename V>
+            [[gnu::always_inline]] V next(const uint64_t *up, const uint64_t *mid, const uint64_t *down) const noexcept {
+                const Counts<V> counts = neighbourCounts<V, true>(up, mid, down);
+                V born{}, survives{};
+                for (int count = 0; count <= 8; ++count) {
+                    if (!((birth | survive) >> count & 1)) continue;
+                    const V is = countIs<V, true>(counts, count);
+                    if (birth >> count & 1) born |= is;
+                    if (survive >> count & 1) survives |= is;
+                }
+                return (born & ~counts.alive) | (survives & counts.alive);
+            }
+        };
+
+        template<typename V, typename Next>
+        [[gnu::always_inline]] inline bool stepTile(const BitBoard &src, BitBoard &dst, const int firstRow,
+                                                    const int lastRow, const size_t firstWord, const size_t lastWord,
+                                                    const Next &rule) noexcept {
+            constexpr size_t lanes = sizeof(V) / sizeof(uint64_t);
+            // the last word of a row is masked, so it is always left to the scalar loop
+            const size_t vectorEnd = lastWord == src.words() ? lastWord - 1 : lastWord;
+            V diff{};
+            uint64_t diffScalar = 0;
+            for (int y = firstRow; y < lastRow; ++y) {
+                const uint64_t *up = src.row(y - 1), *mid = src.row(y), *down = src.row(y + 1);
+                uint64_t *out = dst.row(y);
+
+                size_t i = firstWord;
+                if constexpr (lanes > 1) {
+                    for (; i + lanes <= vectorEnd; i += lanes) {
+                        const V next = rule.template next<V>(up + i, mid + i, down + i);
+                        diff |= next ^ load<V>(mid + i);
+                        store(out + i, next);
+                    }
+                }
+                for (; i < lastWord; ++i) {
+                    // cells past the width must stay dead, they would otherwise be born next to the right edge
+                    const uint64_t mask = i + 1 == src.words() ? src.tailMask() : ~0ull;
+                    out[i] = rule.template next<uint64_t>(up + i, mid + i, down + i) & mask;
+                    diffScalar |= out[i] ^ mid[i];
+                }
+            }
+
+            if constexpr (lanes > 1)
+                for (size_t l = 0; l < lanes; ++l) diffScalar |= diff[l];
+            return diffScalar != 0;
+        }
+
+        template<typename Next>
+        bool stepTileScalar(const BitBoard &src, BitBoard &dst, const int firstRow, const int lastRow,
+                            const size_t firstWord, const size_t lastWord, const LifeRule &rule) noexcept {
+            return stepTile<uint64_t>(src, dst, firstRow, lastRow, firstWord, lastWord, Next::make(rule));
+        }
+
+#if LIFE_X86_SIMD
+        template<typename Next>
+        __attribute__((target("avx2")))
+        bool stepTileAvx2(const BitBoard &src, BitBoard &dst, const int firstRow, const int lastRow,
+                          const size_t firstWord, const size_t lastWord, const LifeRule &rule) noexcept {
+            return stepTile<Vec4>(src, dst, firstRow, lastRow, firstWord, lastWord, Next::make(rule));
+        }
+
+        template<typename Next>
+        __attribute__((target("avx512f")))
+        bool stepTileAvx512(const BitBoard &src, BitBoard &dst, const int firstRow, const int lastRow,
+                            const size_t firstWord, const size_t lastWord, const LifeRule &rule) noexcept {
+            return stepTile<Vec8>(src, dst, firstRow, lastRow, firstWord, lastWord, Next::make(rule));
+        }
+#endif
+
+        /// The steppers of every kernel for one rule, birth == survive == 0 for the runtime fallback.
+        struct Steppers {
+            uint64_t birth, survive;
+            TileStepper scalar, avx2, avx512;
+        };
+
+        template<typename Next>
+        constexpr Steppers steppersFor(const uint64_t birth, const uint64_t survive) noexcept {
+#if LIFE_X86_SIMD
+            return {birth, survive, &stepTileScalar<Next>, &stepTileAvx2<Next>, &stepTileAvx512<Next>};
+#else
+            return {birth, survive, &stepTileScalar<Next>, nullptr, nullptr};
+#endif
+        }
+
+        template<uint64_t Birth, uint64_t Survive>
+        constexpr Steppers specialise() noexcept { return steppersFor<StaticNext<Birth, Survive>>(Birth, Survive); }
+
+        /// Rules with a kernel of their own. Add a line to benchmark another rule at full speed.
+        constexpr Steppers specialised[] = {
+            specialise<countMask("3"), countMask("23")>(), // Conway's Life
+            specialise<countMask("36"), countMask("23")>(), // HighLife
+            specialise<countMask("2"), countMask("")>(), // Seeds
+            specialise<countMask("3"), countMask("012345678")>(), // Life without Death
+            specialise<countMask("3678"), countMask("34678")>(), // Day & Night
+            specialise<countMask("3"), countMask("12345")>(), // Maze
+            specialise<countMask("1357"), countMask("1357")>(), // Replicator
+            specialise<countMask("368"), countMask("245")>(), // Morley
+            specialise<countMask("36"), countMask("125")>(), // 2x2
+            specialise<countMask("35678"), countMask("5678")>(), // Diamoeba
+        };
+
+        constexpr Steppers runtime = steppersFor<RuntimeNext>(0, 0);
+    }
+
+    const char *kernelName(const Kernel kernel) noexcept {
+        switch (kernel) {
+            case Kernel::Auto: return "auto";
+            case Kernel::Scalar: return "scalar";
+            case Kernel::Avx2: return "avx2";
+            case Kernel::Avx512: return "avx512";
+        }
+        return "unknown";
+    }
+
+    Kernel kernelParse(const std::string_view name) {
+        for (const Kernel kernel: {Kernel::Auto, Kernel::Scalar, Kernel::Avx2, Kernel::Avx512})
+            if (name == kernelName(kernel)) return kernel;
+        throw std::invalid_argument("Unknown kernel " + std::string(name));
+    }
+
+    bool kernelSupported(const Kernel kernel) noexcept {
+        switch (kernel) {
+            case Kernel::Auto:
+            case Kernel::Scalar: return true;
+#if LIFE_X86_SIMD
+            case Kernel::Avx2: return __builtin_cpu_supports("avx2");
+            case Kernel::Avx512: return __builtin_cpu_supports("avx512f");
+#else
+            case Kernel::Avx2:
+            case Kernel::Avx512: return false;
+#endif
+        }
+        return false;
+    }
+
+    Kernel kernelResolve(const Kernel kernel) noexcept {
+        if (kernel == Kernel::Auto || !kernelSupported(kernel)) {
+            if ((kernel == Kernel::Auto || kernel == Kernel::Avx512) && kernelSupported(Kernel::Avx512))
+                return Kernel::Avx512;
+            if (kernel != Kernel::Scalar && kernelSupported(Kernel::Avx2)) return Kernel::Avx2;
+            return Kernel::Scalar;
+        }
+        return kernel;
+    }
+
+    bool kernelSpecialised(const LifeRule &rule) noexcept {
+        return std::ranges::any_of(specialised, [&](const Steppers &steppers) {
+            return steppers.birth == rule.birth && steppers.survive == rule.survive;
+        });
+    }
+
+    TileStepper kernelStepper(const Kernel kernel, const LifeRule &rule) noexcept {
+        const Steppers *steppers = &runtime;
+        for (const Steppers &candidate: specialised)
+            if (candidate.birth == rule.birth && candidate.survive == rule.survive) steppers = &candidate;
+        switch (kernel) {
+#if LIFE_X86_SIMD
+            case Kernel::Avx2: return steppers->avx2;
+            case Kernel::Avx512: return steppers->avx512;
+#endif
+            default: return steppers->scalar;
+        }
+    }
+
+    bool kernelStepRows(const BitBoard &src, BitBoard &dst, const int firstRow, const int lastRow,
+                        const Kernel kernel, const LifeRule &rule) noexcept {
+        return kernelStepper(kernel, rule)(src, dst, firstRow, lastRow, 0, src.words(), rule);
+    }
+}
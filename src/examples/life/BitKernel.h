@@ -0,0 +1,72 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BITKERNEL_H
+#define X11TEST_BITKERNEL_H
+#include <cstddef>
+#include <string_view>
+
+#include "BitBoard.h"
+#include "LifeRule.h"
+
+// Build with -DLIFE_SIMD=0 to compile only the portable kernel
+#ifndef LIFE_SIMD
+#define LIFE_SIMD 1
+#endif
+
+namespace GameOfLife {
+    /// Implementations of the bit-parallel step. All produce identical boards.
+    enum class Kernel {
+        Auto, // the fastest kernel the CPU supports
+        Scalar, // one 64 bit word at a time, portable
+        Avx2, // 4 words at a time
+        Avx512 // 8 words at a time
+    };
+
+    /// @return The name of the kernel, as accepted by kernelParse.
+    [[nodiscard]] const char *kernelName(Kernel kernel) noexcept;
+
+    /// @return The kernel with the given name.
+    /// @throws std::invalid_argument if the name is unknown.
+    [[nodiscard]] Kernel kernelParse(std::string_view name);
+
+    /// @return True if the kernel was compiled in and the CPU supports it.
+    [[nodiscard]] bool kernelSupported(Kernel kernel) noexcept;
+
+    /// Resolve Auto to the fastest supported kernel, and unsupported kernels to the next slower one.
+    [[nodiscard]] Kernel kernelResolve(Kernel kernel) noexcept;
+
+    /**
+     * Computes the words [firstWord, lastWord) of rows [firstRow, lastRow) of the next generation of src into dst.
+     * Tiles only read src and only write their own part of dst, so disjoint tiles can be stepped concurrently.
+     * @param src The current generation.
+     * @param dst The next generation, must have the same dimensions as src.
+     * @param firstRow The first row to compute.
+     * @param lastRow One past the last row to compute.
+     * @param firstWord The first word of each row to compute.
+     * @param lastWord One past the last word to compute, at most src.words().
+     * @param rule The rule the stepper was resolved for.
+     * @return True if any computed cell differs from src.
+     */
+    using TileStepper = bool (*)(const BitBoard &src, BitBoard &dst, int firstRow, int lastRow, size_t firstWord,
+                                 size_t lastWord, const LifeRule &rule) noexcept;
+
+    /// @return True if the rule has kernels specialised for it at compile time, other Life-like rules run on a
+    /// generic kernel that tests the neighbour counts at runtime.
+    [[nodiscard]] bool kernelSpecialised(const LifeRule &rule) noexcept;
+
+    /// @param kernel The implementation to use, must be resolved.
+    /// @param rule A Life-like rule, see LifeRule::lifeLike.
+    /// @return The fastest stepper for the rule.
+    [[nodiscard]] TileStepper kernelStepper(Kernel kernel, const LifeRule &rule) noexcept;
+
+    /// Compute rows [firstRow, lastRow) of the next generation of src into dst.
+    /// @param kernel The implementation to use, must be resolved.
+    /// @param rule A Life-like rule.
+    /// @return True if any computed cell differs from src.
+    bool kernelStepRows(const BitBoard &src, BitBoard &dst, int firstRow, int lastRow, Kernel kernel,
+                        const LifeRule &rule = {}) noexcept;
+}
+
+#endif //X11TEST_BITKERNEL_H
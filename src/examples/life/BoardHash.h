@@ -0,0 +1,78 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BOARDHASH_H
+#define X11TEST_BOARDHASH_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "BitBoard.h"
+
+namespace GameOfLife {
+    /**
+     * Zobrist-style hash contribution of word i of row y of a bit-packed board. The hash of a board is the XOR of
+     * the contributions of all its words, and empty words contribute 0, so it can be updated word by word or tile
+     * by tile without looking at the rest of the board.
+     */
+    [[nodiscard]] constexpr uint64_t boardWordHash(const uint64_t word, const int y, const size_t i) noexcept {
+        if (word == 0) return 0;
+        // the murmur3 finaliser over the word keyed by its position
+        uint64_t h = word ^ (static_cast<uint64_t>(y) * 0x9E3779B97F4A7C15ull + i * 0xC2B2AE3D27D4EB4Full);
+        h = (h ^ h >> 33) * 0xFF51AFD7ED558CCDull;
+        h = (h ^ h >> 33) * 0xC4CEB9FE1A85EC53ull;
+        return h ^ h >> 33;
+    }
+
+    /// Hash contribution of a cell in a dying state (2 and up) of a Generations rule, so boards that only differ in
+    /// their dying cells do not look alike. Live and dead cells are covered by boardWordHash.
+    [[nodiscard]] constexpr uint64_t boardStateHash(const uint8_t state, const int x, const int y) noexcept {
+        uint64_t h = state * 0xD6E8FEB86659FD93ull ^ (static_cast<uint64_t>(y) * 0x9E3779B97F4A7C15ull +
+                                                      static_cast<uint64_t>(x) * 0x94D049BB133111EBull);
+        h = (h ^ h >> 33) * 0xFF51AFD7ED558CCDull;
+        h = (h ^ h >> 33) * 0xC4CEB9FE1A85EC53ull;
+        return h ^ h >> 33;
+    }
+
+    /**
+     * Hash contribution of the cells [64 i, 64 i + 64) of row y of a board with one byte of state per cell, as used
+     * by the byte engines: live cells (state 1) hash exactly like the same word of a BitBoard, so such a board
+     * hashes like its snapshot as long as no cell is dying.
+     */
+    [[nodiscard]] inline uint64_t byteWordHash(const uint8_t *row, const int width, const int y,
+                                               const size_t i) noexcept {
+        const int first = static_cast<int>(i * 64), last = std::min(width, first + 64);
+        uint64_t word = 0, dying = 0;
+        for (int x = first; x < last; ++x) {
+            word |= static_cast<uint64_t>(row[x] == 1) << (x - first);
+            if (row[x] >= 2) dying ^= boardStateHash(row[x], x, y);
+        }
+        return boardWordHash(word, y, i) ^ dying;
+    }
+
+    /// @return The hash contribution of a whole row of byte states.
+    [[nodiscard]] inline uint64_t byteRowHash(const uint8_t *row, const int width, const int y) noexcept {
+        uint64_t hash = 0;
+        for (size_t i = 0; i * 64 < static_cast<size_t>(width); ++i) hash ^= byteWordHash(row, width, y, i);
+        return hash;
+    }
+
+    /// @return The hash of the words [firstWord, lastWord) of rows [firstRow, lastRow).
+    [[nodiscard]] inline uint64_t boardHash(const BitBoard &board, const int firstRow, const int lastRow,
+                                            const size_t firstWord, const size_t lastWord) noexcept {
+        uint64_t hash = 0;
+        for (int y = firstRow; y < lastRow; ++y) {
+            const uint64_t *row = board.row(y);
+            for (size_t i = firstWord; i < lastWord; ++i) hash ^= boardWordHash(row[i], y, i);
+        }
+        return hash;
+    }
+
+    /// @return The hash of the whole board.
+    [[nodiscard]] inline uint64_t boardHash(const BitBoard &board) noexcept {
+        return boardHash(board, 0, board.height(), 0, board.words());
+    }
+}
+
+#endif //X11TEST_BOARDHASH_H
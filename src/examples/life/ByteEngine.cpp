@@ -0,0 +1,61 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "ByteEngine.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace GameOfLife {
+    ByteEngine::ByteEngine(const int width, const int height) : m_Width(width), m_Height(height) {
+        if (width <= 0 || height <= 0) throw std::invalid_argument("Board dimensions must be positive");
+        m_Cells.assign(static_cast<size_t>(width) * height, 0);
+        m_Next.assign(m_Cells.size(), 0);
+    }
+
+    bool ByteEngine::get(const int x, const int y) const noexcept {
+        if (x < 0 || x >= m_Width || y < 0 || y >= m_Height) return false;
+        return m_Cells[static_cast<size_t>(y) * m_Width + x];
+    }
+
+    void ByteEngine::set(const int x, const int y, const bool alive) noexcept {
+        if (x < 0 || x >= m_Width || y < 0 || y >= m_Height) return;
+        const uint8_t *row = &m_Cells[static_cast<size_t>(y) * m_Width];
+        const size_t word = static_cast<size_t>(x) / 64;
+        m_Hash ^= byteWordHash(row, m_Width, y, word);
+        m_Cells[static_cast<size_t>(y) * m_Width + x] = alive;
+        m_Hash ^= byteWordHash(row, m_Width, y, word);
+    }
+
+    void ByteEngine::clear() noexcept {
+        std::ranges::fill(m_Cells, 0);
+        m_Generation = 0;
+        m_Hash = 0;
+    }
+
+    void ByteEngine::step() {
+        uint64_t hash = 0;
+        for (int y = 0; y < m_Height; ++y) {
+            for (int x = 0; x < m_Width; ++x) {
+                int liveNeighbors = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        if (dx == 0 && dy == 0) continue;
+                        liveNeighbors += get(x + dx, y + dy) ? 1 : 0;
+                    }
+                }
+                const bool alive = m_Cells[static_cast<size_t>(y) * m_Width + x];
+                m_Next[static_cast<size_t>(y) * m_Width + x] = alive
+                                                                   ? liveNeighbors == 2 || liveNeighbors == 3
+                                                                   : liveNeighbors == 3;
+            }
+            // while the row is still in cache
+            hash ^= byteRowHash(&m_Next[static_cast<size_t>(y) * m_Width], m_Width, y);
+        }
+
+        m_Cells.swap(m_Next);
+        m_Hash = hash;
+        m_Generation++;
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_BYTEENGINE_H
+#define X11TEST_BYTEENGINE_H
+#include <cstdint>
+#include <vector>
+
+#include "LifeEngine.h"
+
+namespace GameOfLife {
+    /**
+     * The original engine: one byte per cell and a bounds checked neighbour count per cell.
+     * Slow, but simple enough to serve as the reference the other engines are checked against.
+     */
+    class ByteEngine final : public LifeEngine {
+        int m_Width, m_Height;
+        uint64_t m_Generation = 0;
+        uint64_t m_Hash = 0; // byteRowHash of all rows, updated by step and set
+        std::vector<uint8_t> m_Cells, m_Next; // row major
+
+    public:
+        ByteEngine(int width, int height);
+
+        [[nodiscard]] const char *name() const noexcept override { return "bytes"; }
+        [[nodiscard]] int width() const noexcept override { return m_Width; }
+        [[nodiscard]] int height() const noexcept override { return m_Height; }
+        [[nodiscard]] uint64_t generation() const noexcept override { return m_Generation; }
+        void setGeneration(const uint64_t generation) noexcept override { m_Generation = generation; }
+
+        [[nodiscard]] bool get(int x, int y) const noexcept override;
+
+        void set(int x, int y, bool alive) noexcept override;
+
+        void clear() noexcept override;
+
+        [[nodiscard]] uint64_t hash() noexcept override { return m_Hash; }
+
+        void step() override;
+    };
+}
+
+#endif //X11TEST_BYTEENGINE_H
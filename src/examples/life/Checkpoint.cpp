@@ -0,0 +1,423 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "Checkpoint.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+
+#include "PatternIO.h"
+
+static_assert(std::endian::native == std::endian::little, "checkpoints are written in host byte order");
+
+namespace GameOfLife {
+    namespace {
+        using namespace CheckpointFormat;
+
+        constexpr size_t tileWordCount = size_t{tileRows} * tileWords;
+
+        [[nodiscard]] constexpr size_t padded(const size_t bytes) noexcept { return (bytes + 7) & ~size_t{7}; }
+
+        template<typename T>
+        [[nodiscard]] std::span<const std::byte> bytesOf(const T &value) noexcept {
+            return std::as_bytes(std::span(&value, 1));
+        }
+
+        [[nodiscard]] uint64_t headerChecksum(const CheckpointHeader &header) noexcept {
+            return checksum(bytesOf(header).first(offsetof(CheckpointHeader, headerChecksum)));
+        }
+
+        /// Continue a checksum over a second range, for the rule and the index.
+        [[nodiscard]] uint64_t checksumCombine(const uint64_t first, const std::span<const std::byte> bytes) noexcept {
+            return first * 0x9E3779B97F4A7C15ull ^ checksum(bytes);
+        }
+
+        /// Size of the valid part of a tile, tiles at the right and bottom edge are cut off by the board.
+        struct TileExtent {
+            int firstRow, rows;
+            size_t firstWord, words;
+        };
+
+        [[nodiscard]] TileExtent tileExtent(const uint64_t tile, const uint64_t tilesX, const int height,
+                                            const size_t boardWords) noexcept {
+            const auto tileY = static_cast<int>(tile / tilesX);
+            const size_t tileX = tile % tilesX;
+            TileExtent extent{tileY * tileRows, 0, tileX * tileWords, 0};
+            extent.rows = std::min<int>(tileRows, height - extent.firstRow);
+            extent.words = std::min<size_t>(tileWords, boardWords - extent.firstWord);
+            return extent;
+        }
+
+        /// Encode the valid words of a tile into out, raw or as zero runs, whichever is smaller.
+        /// @param words Scratch space for the words of the tile.
+        /// @return The encoding, or nullopt if the tile is empty.
+        std::optional<Encoding> encodeTile(const BitBoard &cells, const TileExtent &extent,
+                                           std::vector<uint64_t> &words, std::vector<std::byte> &out) {
+            words.clear();
+            size_t live = 0;
+            for (int y = extent.firstRow; y < extent.firstRow + extent.rows; ++y) {
+                const uint64_t *row = cells.row(y) + extent.firstWord;
+                for (size_t i = 0; i < extent.words; ++i) {
+                    words.push_back(row[i]);
+                    live += row[i] != 0;
+                }
+            }
+            out.clear();
+            if (live == 0) return std::nullopt;
+
+            const auto append = [&out](const void *data, const size_t bytes) {
+                const auto *first = static_cast<const std::byte *>(data);
+                out.insert(out.end(), first, first + bytes);
+            };
+
+            // zero runs cost 4 bytes per run of literals, so they only pay off if enough words are zero
+            size_t runs = 0;
+            for (size_t i = 0; i < words.size(); ++i)
+                if (words[i] != 0 && (i == 0 || words[i - 1] == 0)) runs++;
+            if (runs * 4 + live * 8 >= words.size() * 8) {
+                append(words.data(), words.size() * sizeof(uint64_t));
+                return Encoding::Raw;
+            }
+
+            for (size_t i = 0; i < words.size();) {
+                uint16_t zeros = 0, literals = 0;
+                while (i < words.size() && words[i] == 0 && zeros < UINT16_MAX) ++i, ++zeros;
+                const size_t first = i;
+                while (i < words.size() && words[i] != 0 && literals < UINT16_MAX) ++i, ++literals;
+                append(&zeros, sizeof(zeros));
+                append(&literals, sizeof(literals));
+                append(words.data() + first, literals * sizeof(uint64_t));
+            }
+            out.resize(padded(out.size()));
+            return Encoding::ZeroRuns;
+        }
+
+        [[noreturn]] void corrupt(const std::string &what) { throw std::runtime_error("Corrupt checkpoint: " + what); }
+
+        struct FileCloser {
+            void operator()(std::FILE *file) const noexcept { std::fclose(file); }
+        };
+    }
+
+    uint64_t checksum(const std::span<const std::byte> bytes) noexcept {
+        constexpr uint64_t mul = 0x9E3779B97F4A7C15ull;
+        uint64_t h = bytes.size() * mul;
+        size_t i = 0;
+        for (; i + 8 <= bytes.size(); i += 8) {
+            uint64_t word;
+            std::memcpy(&word, bytes.data() + i, 8);
+            h = (std::rotl(h, 23) ^ word) * mul;
+        }
+        uint64_t tail = 0;
+        if (i < bytes.size()) std::memcpy(&tail, bytes.data() + i, bytes.size() - i);
+        h = (std::rotl(h, 23) ^ tail) * mul;
+        return h ^ h >> 31;
+    }
+
+    std::string CheckpointStats::toString() const {
+        return std::format("generation {}, {} of {} tiles, {:.1f} KiB in {:.1f} ms", generation, storedTiles, tiles,
+                           static_cast<double>(bytes) / 1024, seconds * 1000);
+    }
+
+    CheckpointStats checkpointWrite(const BitBoard &cells, const uint64_t generation, const LifeRule &rule,
+                                    const std::string &path, const int originX, const int originY) {
+        if (rule.states > 2)
+            throw std::invalid_argument("Checkpoints only store live cells, the dying states of " + rule.toString() +
+                                        " would be lost");
+        const auto start = std::chrono::steady_clock::now();
+        const std::string tmpPath = path + ".tmp";
+        std::unique_ptr<std::FILE, FileCloser> file(std::fopen(tmpPath.c_str(), "wb"));
+        if (!file) throw std::runtime_error("Failed to open " + tmpPath + " for writing");
+
+        uint64_t offset = 0;
+        const auto write = [&](const void *data, const size_t bytes) {
+            if (bytes == 0) return;
+            if (std::fwrite(data, 1, bytes, file.get()) != bytes) {
+                file.reset();
+                std::remove(tmpPath.c_str());
+                throw std::runtime_error("Failed to write " + tmpPath);
+            }
+            offset += bytes;
+        };
+
+        CheckpointHeader header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.version = version;
+        header.headerBytes = sizeof(CheckpointHeader);
+        header.width = cells.width();
+        header.height = cells.height();
+        header.generation = generation;
+        header.tileRows = tileRows;
+        header.tileWords = tileWords;
+        header.originX = originX;
+        header.originY = originY;
+        // filled in once the tiles are written
+        write(&header, sizeof(header));
+
+        std::string ruleText = rule.toString();
+        header.ruleBytes = static_cast<uint32_t>(ruleText.size());
+        ruleText.resize(padded(ruleText.size()), '\0');
+        write(ruleText.data(), ruleText.size());
+
+        // tiles go out one at a time, so the writer never holds more than one encoded tile
+        const uint64_t tilesX = (cells.words() + tileWords - 1) / tileWords;
+        const uint64_t tilesY = (static_cast<uint64_t>(cells.height()) + tileRows - 1) / tileRows;
+        std::vector<CheckpointTile> index;
+        std::vector<uint64_t> words;
+        std::vector<std::byte> payload;
+        for (uint64_t tile = 0; tile < tilesX * tilesY; ++tile) {
+            const std::optional<Encoding> encoding = encodeTile(
+                cells, tileExtent(tile, tilesX, cells.height(), cells.words()), words, payload);
+            if (!encoding) continue;
+            index.push_back({tile, offset, static_cast<uint32_t>(payload.size()), *encoding, checksum(payload)});
+            write(payload.data(), payload.size());
+        }
+
+        header.indexOffset = offset;
+        header.tileCount = index.size();
+        write(index.data(), index.size() * sizeof(CheckpointTile));
+
+        header.indexChecksum = checksumCombine(checksum(std::as_bytes(std::span(ruleText))),
+                                               std::as_bytes(std::span(index)));
+        header.headerChecksum = headerChecksum(header);
+        const uint64_t size = offset;
+        if (std::fseek(file.get(), 0, SEEK_SET) != 0) {
+            file.reset();
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Failed to seek in " + tmpPath);
+        }
+        write(&header, sizeof(header));
+
+        // the data has to be on disk before the rename makes it the checkpoint
+        if (std::fflush(file.get()) != 0 || fsync(fileno(file.get())) != 0) {
+            file.reset();
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Failed to write " + tmpPath);
+        }
+        file.reset();
+        if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+            std::remove(tmpPath.c_str());
+            throw std::runtime_error("Failed to rename " + tmpPath + " to " + path);
+        }
+
+        return {
+            path, generation, size, tilesX * tilesY, index.size(),
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+        };
+    }
+
+    CheckpointStats checkpointWrite(const LifeEngine &engine, const std::string &path) {
+        const CellRect extent = engine.extent();
+        BitBoard cells;
+        engine.snapshotArea(cells, extent);
+        return checkpointWrite(cells, engine.generation(), engine.rule(), path, extent.x, extent.y);
+    }
+
+    bool checkpointIs(const std::string &path) noexcept {
+        std::unique_ptr<std::FILE, FileCloser> file(std::fopen(path.c_str(), "rb"));
+        char start[sizeof(magic)];
+        return file && std::fread(start, 1, sizeof(start), file.get()) == sizeof(start) &&
+               std::memcmp(start, magic, sizeof(magic)) == 0;
+    }
+
+    Checkpoint::Checkpoint(const std::string &path) : m_File(path) {
+        // version 1 headers end with the checksum where the origin starts now
+        constexpr size_t headerBytesV1 = offsetof(CheckpointHeader, originX) + sizeof(uint64_t);
+        const std::string_view file = m_File.view();
+        if (file.size() < headerBytesV1 || std::memcmp(file.data(), magic, sizeof(magic)) != 0)
+            throw std::runtime_error(path + " is not a checkpoint");
+        std::memcpy(&m_Header, file.data(), offsetof(CheckpointHeader, originX));
+        if (m_Header.version != version && m_Header.version != 1)
+            throw std::runtime_error(path + " has checkpoint version " + std::to_string(m_Header.version) +
+                                     ", expected " + std::to_string(version));
+        const size_t headerBytes = m_Header.version == 1 ? headerBytesV1 : sizeof(CheckpointHeader);
+        if (file.size() < headerBytes) corrupt(path + " truncated");
+        if (m_Header.version == 1) {
+            std::memcpy(&m_Header.headerChecksum, file.data() + offsetof(CheckpointHeader, originX), sizeof(uint64_t));
+            if (m_Header.headerChecksum != checksum(bytesOf(m_Header).first(offsetof(CheckpointHeader, originX))))
+                corrupt(path + " header checksum");
+            m_Header.originX = m_Header.originY = 0;
+        } else {
+            std::memcpy(&m_Header, file.data(), sizeof(m_Header));
+            if (m_Header.headerChecksum != headerChecksum(m_Header)) corrupt(path + " header checksum");
+        }
+        if (m_Header.headerBytes != headerBytes) corrupt(path + " header size");
+        if (m_Header.tileRows != tileRows || m_Header.tileWords != tileWords || m_Header.width <= 0 ||
+            m_Header.height <= 0)
+            corrupt(path + " board geometry");
+
+        const size_t ruleBytes = padded(m_Header.ruleBytes);
+        const uint64_t indexBytes = m_Header.tileCount * sizeof(CheckpointTile);
+        if (m_Header.headerBytes + ruleBytes > file.size() || m_Header.indexOffset > file.size() ||
+            indexBytes > file.size() - m_Header.indexOffset)
+            corrupt(path + " truncated");
+
+        const auto ruleText = std::as_bytes(std::span(file.data() + m_Header.headerBytes, ruleBytes));
+        const auto indexText = std::as_bytes(std::span(file.data() + m_Header.indexOffset, indexBytes));
+        if (checksumCombine(checksum(ruleText), indexText) != m_Header.indexChecksum) corrupt(path + " index checksum");
+
+        try {
+            m_Rule = LifeRule::parse(file.substr(m_Header.headerBytes, m_Header.ruleBytes));
+        } catch (const std::invalid_argument &e) {
+            corrupt(path + " rule: " + e.what());
+        }
+        m_Index.resize(m_Header.tileCount);
+        if (indexBytes != 0) std::memcpy(m_Index.data(), indexText.data(), indexBytes);
+
+        const size_t words = (static_cast<size_t>(m_Header.width) + 63) / 64;
+        m_TilesX = (words + tileWords - 1) / tileWords;
+        m_TilesY = (static_cast<uint64_t>(m_Header.height) + tileRows - 1) / tileRows;
+        for (size_t i = 0; i < m_Index.size(); ++i) {
+            const CheckpointTile &entry = m_Index[i];
+            if (entry.tile >= tileCount() || (i > 0 && entry.tile <= m_Index[i - 1].tile) ||
+                entry.offset > file.size() || entry.bytes > file.size() - entry.offset)
+                corrupt(path + " index entry " + std::to_string(i));
+        }
+    }
+
+    uint64_t Checkpoint::decodeTile(const size_t index, const std::span<uint64_t> words) const {
+        const CheckpointTile &entry = m_Index.at(index);
+        const auto payload = std::as_bytes(std::span(m_File.data() + entry.offset, entry.bytes));
+        if (checksum(payload) != entry.checksum) corrupt("tile " + std::to_string(entry.tile) + " checksum");
+        if (words.size() < tileWordCount) throw std::invalid_argument("Tile buffer too small");
+
+        const size_t boardWords = (static_cast<size_t>(m_Header.width) + 63) / 64;
+        const TileExtent extent = tileExtent(entry.tile, m_TilesX, m_Header.height, boardWords);
+        const size_t valid = static_cast<size_t>(extent.rows) * extent.words;
+        std::ranges::fill(words, 0);
+
+        // the valid words are stored densely, spread them out to rows of tileWords
+        const auto place = [&](const size_t i, const std::byte *data) {
+            std::memcpy(&words[i / extent.words * tileWords + i % extent.words], data, sizeof(uint64_t));
+        };
+        if (entry.encoding == Encoding::Raw) {
+            if (payload.size() != valid * sizeof(uint64_t)) corrupt("tile " + std::to_string(entry.tile) + " size");
+            for (size_t i = 0; i < valid; ++i) place(i, payload.data() + i * sizeof(uint64_t));
+        } else if (entry.encoding == Encoding::ZeroRuns) {
+            size_t i = 0, pos = 0;
+            while (i < valid) {
+                uint16_t zeros, literals;
+                if (pos + 4 > payload.size()) corrupt("tile " + std::to_string(entry.tile) + " truncated");
+                std::memcpy(&zeros, payload.data() + pos, 2);
+                std::memcpy(&literals, payload.data() + pos + 2, 2);
+                pos += 4;
+                i += zeros;
+                if (i + literals > valid || pos + literals * sizeof(uint64_t) > payload.size())
+                    corrupt("tile " + std::to_string(entry.tile) + " runs");
+                for (uint16_t l = 0; l < literals; ++l, ++i, pos += sizeof(uint64_t)) place(i, payload.data() + pos);
+            }
+        } else {
+            corrupt("tile " + std::to_string(entry.tile) + " encoding");
+        }
+        return entry.tile;
+    }
+
+    bool Checkpoint::get(const int x, const int y) const {
+        if (x < 0 || x >= width() || y < 0 || y >= height()) return false;
+        const uint64_t tileX = static_cast<uint64_t>(x / 64) / tileWords;
+        const uint64_t tile = static_cast<uint64_t>(y / tileRows) * m_TilesX + tileX;
+        if (tile != m_CachedTile) {
+            const auto entry = std::ranges::lower_bound(m_Index, tile, {}, &CheckpointTile::tile);
+            if (entry == m_Index.end() || entry->tile != tile) return false;
+            m_Cached.resize(tileWordCount);
+            decodeTile(static_cast<size_t>(entry - m_Index.begin()), m_Cached);
+            m_CachedTile = tile;
+        }
+        const uint64_t word = m_Cached[static_cast<size_t>(y % tileRows) * tileWords + x / 64 % tileWords];
+        return word >> (x % 64) & 1;
+    }
+
+    void Checkpoint::restore(LifeEngine &engine) const {
+        engine.clear();
+        const int originX = engine.bounded() ? 0 : m_Header.originX, originY = engine.bounded() ? 0 : m_Header.originY;
+        std::vector<uint64_t> words(tileWordCount);
+        for (size_t i = 0; i < m_Index.size(); ++i) {
+            const uint64_t tile = decodeTile(i, words);
+            const int firstX = originX + static_cast<int>(tile % m_TilesX * tileWords * 64);
+            const int firstY = originY + static_cast<int>(tile / m_TilesX * tileRows);
+            for (int row = 0; row < tileRows; ++row) {
+                bitRuns(&words[static_cast<size_t>(row) * tileWords], tileWords, [&](const int x, const int length) {
+                    engine.setSpan(firstX + x, firstY + row, length, true);
+                });
+            }
+        }
+        engine.setGeneration(generation());
+    }
+
+    std::string boardLoad(LifeEngine &engine, const std::string &path, const std::optional<PatternStats> &peeked) {
+        if (!checkpointIs(path)) {
+            const PatternStats loaded = peeked ? patternLoadCentred(engine, path, *peeked)
+                                               : patternLoadCentred(engine, path);
+            return "Loaded " + path + ": " + loaded.toString();
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const Checkpoint checkpoint(path);
+        checkpoint.restore(engine);
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return std::format("Restored {}: generation {}, {} of {} tiles in {:.1f} ms", path, checkpoint.generation(),
+                           checkpoint.storedTileCount(), checkpoint.tileCount(), elapsed.count());
+    }
+
+    CheckpointWriter::~CheckpointWriter() {
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_one();
+        if (m_Thread.joinable()) m_Thread.join();
+    }
+
+    bool CheckpointWriter::submit(BitBoard cells, const uint64_t generation, const LifeRule &rule, std::string path,
+                                  const int originX, const int originY) {
+        {
+            std::lock_guard lock(m_Mutex);
+            if (m_Busy) return false;
+            m_Busy = true;
+            m_Job.emplace(Job{std::move(cells), generation, rule, std::move(path), originX, originY});
+        }
+        if (!m_Thread.joinable()) m_Thread = std::thread(&CheckpointWriter::loop, this);
+        m_Wake.notify_one();
+        return true;
+    }
+
+    std::vector<std::string> CheckpointWriter::takeResults() {
+        std::lock_guard lock(m_Mutex);
+        return std::exchange(m_Results, {});
+    }
+
+    void CheckpointWriter::loop() {
+        std::unique_lock lock(m_Mutex);
+        while (true) {
+            // a job submitted right before stopping is still written
+            m_Wake.wait(lock, [this] { return m_Job.has_value() || m_Stop; });
+            if (!m_Job) return;
+            const Job job = std::move(*m_Job);
+            m_Job.reset();
+            lock.unlock();
+
+            std::string result;
+            try {
+                result = "Saved checkpoint " + job.path + ": " +
+                         checkpointWrite(job.cells, job.generation, job.rule, job.path, job.originX, job.originY)
+                         .toString();
+            } catch (const std::exception &e) {
+                result = std::string("Error: ") + e.what();
+            }
+
+            lock.lock();
+            m_Results.push_back(std::move(result));
+            m_Busy = false;
+        }
+    }
+}
@@ -0,0 +1,209 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_CHECKPOINT_H
+#define X11TEST_CHECKPOINT_H
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../../core/lib/MappedFile.h"
+#include "BitBoard.h"
+#include "LifeEngine.h"
+#include "LifeRule.h"
+#include "PatternIO.h"
+
+namespace GameOfLife {
+    /**
+     * Binary checkpoint of a board, version 2. All integers are little endian.
+     *
+     *   CheckpointHeader
+     *   rule            ruleBytes of LifeRule::toString(), padded to 8 bytes
+     *   tile payloads   one per stored tile, in tile order
+     *   index           tileCount CheckpointTile entries, sorted by tile
+     *
+     * The board is split into tiles of tileRows x tileWords words. Empty tiles are not stored at all, the others
+     * either raw or as runs of zero words and literal words, whichever is smaller. Every payload has its own
+     * checksum, so a reader only touches the tiles it decodes.
+     *
+     * Cell (0, 0) of the board is cell (originX, originY) of the engine, so a checkpoint of an unbounded engine only
+     * has to cover its live cells. Version 1 had no origin, its header ends with indexChecksum and headerChecksum.
+     *
+     * Only the live bit plane is stored. The dying states of Generations rules (more than 2 states) would be lost
+     * and the board would run differently after a restore, so checkpointWrite refuses those rules.
+     */
+    namespace CheckpointFormat {
+        constexpr char magic[8] = {'L', 'I', 'F', 'E', 'C', 'K', 'P', 'T'};
+        constexpr uint32_t version = 2;
+        constexpr uint16_t tileRows = 64;
+        constexpr uint16_t tileWords = 8;
+
+        enum class Encoding : uint32_t {
+            Raw = 1, // the valid words of the tile, row by row
+            ZeroRuns = 2 // uint16 zero words, uint16 literal words, then the literals, until the tile is covered
+        };
+    }
+
+    struct CheckpointHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerBytes;
+        int32_t width, height;
+        uint64_t generation;
+        uint16_t tileRows, tileWords;
+        uint32_t ruleBytes;
+        uint64_t indexOffset;
+        uint64_t tileCount; // stored tiles, empty ones are left out
+        uint64_t indexChecksum; // over the rule and the index
+        int32_t originX, originY; // engine coordinates of cell (0, 0), since version 2
+        uint64_t headerChecksum; // over all fields above
+    };
+
+    static_assert(sizeof(CheckpointHeader) == 80);
+
+    struct CheckpointTile {
+        uint64_t tile; // tileY * tilesX + tileX
+        uint64_t offset; // of the payload from the start of the file
+        uint32_t bytes;
+        CheckpointFormat::Encoding encoding;
+        uint64_t checksum; // over the payload
+    };
+
+    static_assert(sizeof(CheckpointTile) == 32);
+
+    struct CheckpointStats {
+        std::string path{};
+        uint64_t generation = 0;
+        size_t bytes = 0;
+        uint64_t tiles = 0; // of the board
+        uint64_t storedTiles = 0; // tiles with live cells
+        double seconds = 0;
+
+        /// @return e.g. "generation 1200, 12 of 4096 tiles, 8.1 KiB in 3.0 ms".
+        [[nodiscard]] std::string toString() const;
+    };
+
+    /// @return A 64 bit checksum of the bytes, not cryptographic.
+    [[nodiscard]] uint64_t checksum(std::span<const std::byte> bytes) noexcept;
+
+    /**
+     * Write a checkpoint, tile by tile, to path + ".tmp" and rename it over path once it is complete, so an
+     * interrupted write never replaces a good checkpoint.
+     * @param originX Engine coordinates of cells(0, 0), e.g. of a copy of LifeEngine::extent.
+     * @param originY See originX.
+     * @throws std::invalid_argument if the rule has more than 2 states, see CheckpointFormat.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    CheckpointStats checkpointWrite(const BitBoard &cells, uint64_t generation, const LifeRule &rule,
+                                    const std::string &path, int originX = 0, int originY = 0);
+
+    /// Copy LifeEngine::extent of the engine and write it as a checkpoint. Must be called on the thread that owns
+    /// the engine.
+    /// @throws std::invalid_argument if the rule has more than 2 states, see CheckpointFormat.
+    /// @throws std::runtime_error if the file cannot be written.
+    CheckpointStats checkpointWrite(const LifeEngine &engine, const std::string &path);
+
+    /// @return True if the file starts with the checkpoint magic, so it can be told apart from pattern files.
+    [[nodiscard]] bool checkpointIs(const std::string &path) noexcept;
+
+    /**
+     * A checkpoint file, memory mapped. Opening only validates the header and the index; tiles are decoded when
+     * they are asked for, so opening a checkpoint of any size is near-instant and restoring a sparse board only
+     * costs its stored tiles.
+     */
+    class Checkpoint {
+        X11App::MappedFile m_File;
+        CheckpointHeader m_Header{};
+        LifeRule m_Rule{};
+        std::vector<CheckpointTile> m_Index{};
+        uint64_t m_TilesX = 0, m_TilesY = 0;
+        mutable std::vector<uint64_t> m_Cached{}; // decoded words of m_CachedTile
+        mutable uint64_t m_CachedTile = ~uint64_t{0};
+
+    public:
+        /// @throws std::runtime_error if the file cannot be read, has another version or fails a checksum.
+        explicit Checkpoint(const std::string &path);
+
+        [[nodiscard]] int width() const noexcept { return m_Header.width; }
+        [[nodiscard]] int height() const noexcept { return m_Header.height; }
+        [[nodiscard]] int originX() const noexcept { return m_Header.originX; }
+        [[nodiscard]] int originY() const noexcept { return m_Header.originY; }
+        [[nodiscard]] uint64_t generation() const noexcept { return m_Header.generation; }
+        [[nodiscard]] const LifeRule &rule() const noexcept { return m_Rule; }
+        [[nodiscard]] uint64_t tileCount() const noexcept { return m_TilesX * m_TilesY; }
+        [[nodiscard]] uint64_t storedTileCount() const noexcept { return m_Index.size(); }
+
+        /**
+         * Decode the index-th stored tile into words, tileRows x tileWords row major. Words past the board are 0.
+         * @return The tile number, tileY * tilesX + tileX.
+         * @throws std::runtime_error if the payload is corrupt.
+         */
+        uint64_t decodeTile(size_t index, std::span<uint64_t> words) const;
+
+        /// Look up a single cell of the board, decoding only its tile (the last one is cached). Coordinates are
+        /// relative to the origin.
+        /// @throws std::runtime_error if the payload is corrupt.
+        [[nodiscard]] bool get(int x, int y) const;
+
+        /// Clear the engine and write the stored tiles into it, run by run, then set its generation. Unbounded engines
+        /// get the cells back at the origin they were saved from, bounded ones at (0, 0), where their board is.
+        /// @throws std::runtime_error if a payload is corrupt.
+        void restore(LifeEngine &engine) const;
+    };
+
+    /// Restore a checkpoint, or load a pattern file centred on the board.
+    /// @param peeked The patternPeek of the pattern file if the caller has one already, saves reading it again.
+    /// @return A line for the log.
+    /// @throws std::runtime_error if the file cannot be read or is malformed.
+    std::string boardLoad(LifeEngine &engine, const std::string &path,
+                          const std::optional<PatternStats> &peeked = std::nullopt);
+
+    /**
+     * Writes checkpoints on a background thread, so saving a huge board neither stalls the simulation nor the UI.
+     * The caller hands over a copy of the board, e.g. of the snapshot it displays.
+     */
+    class CheckpointWriter {
+        struct Job {
+            BitBoard cells;
+            uint64_t generation;
+            LifeRule rule;
+            std::string path;
+            int originX, originY;
+        };
+
+        std::thread m_Thread{};
+        std::mutex m_Mutex{};
+        std::condition_variable m_Wake{};
+        std::optional<Job> m_Job{}; // guarded by m_Mutex
+        bool m_Busy = false; // guarded by m_Mutex, a job was submitted and is not finished yet
+        bool m_Stop = false; // guarded by m_Mutex
+        std::vector<std::string> m_Results{}; // guarded by m_Mutex, one line per finished job
+
+        void loop();
+
+    public:
+        CheckpointWriter() = default;
+
+        CheckpointWriter(const CheckpointWriter &) = delete;
+        CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+        /// Finishes the checkpoint being written, if any.
+        ~CheckpointWriter();
+
+        /// Start writing a checkpoint in the background, see checkpointWrite.
+        /// @return False if the previous checkpoint is still being written, nothing is written then.
+        bool submit(BitBoard cells, uint64_t generation, const LifeRule &rule, std::string path, int originX = 0,
+                    int originY = 0);
+
+        /// @return A line per checkpoint finished or failed since the last call, for the log.
+        [[nodiscard]] std::vector<std::string> takeResults();
+    };
+}
+
+#endif //X11TEST_CHECKPOINT_H
@@ -0,0 +1,59 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "CycleDetector.h"
+
+#include <stdexcept>
+
+namespace GameOfLife {
+    const char *cycleActionName(const CycleAction action) noexcept {
+        switch (action) {
+            case CycleAction::Ignore: return "ignore";
+            case CycleAction::Report: return "report";
+            case CycleAction::Pause: return "pause";
+        }
+        return "?";
+    }
+
+    CycleAction cycleActionParse(const std::string_view name) {
+        for (const CycleAction action: {CycleAction::Ignore, CycleAction::Report, CycleAction::Pause})
+            if (name == cycleActionName(action)) return action;
+        throw std::invalid_argument("Unknown cycle action: " + std::string(name));
+    }
+
+    std::string Cycle::toString() const {
+        const std::string since = " since generation " + std::to_string(start);
+        if (period == 1) return "still life" + since;
+        return "period " + std::to_string(period) + since;
+    }
+
+    CycleDetector::CycleDetector(const size_t capacity) : m_History(capacity == 0 ? 1 : capacity) {
+        m_Index.reserve(m_History.size());
+    }
+
+    bool CycleDetector::push(const uint64_t generation, const uint64_t hash) {
+        if (m_Cycle) return false;
+        if (const auto it = m_Index.find(hash); it != m_Index.end()) {
+            m_Cycle = Cycle{generation - it->second, it->second};
+            return true;
+        }
+
+        if (m_Size == m_History.size()) {
+            // the oldest hash falls out of the window
+            m_Index.erase(m_History[m_Next].hash);
+        } else {
+            m_Size++;
+        }
+        m_History[m_Next] = {hash, generation};
+        m_Index.emplace(hash, generation);
+        m_Next = (m_Next + 1) % m_History.size();
+        return false;
+    }
+
+    void CycleDetector::reset() noexcept {
+        m_Next = m_Size = 0;
+        m_Index.clear();
+        m_Cycle.reset();
+    }
+}
@@ -0,0 +1,81 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_CYCLEDETECTOR_H
+#define X11TEST_CYCLEDETECTOR_H
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace GameOfLife {
+    /// What the simulation does once the board repeats itself.
+    enum class CycleAction {
+        Ignore, // no hashing at all
+        Report, // publish the cycle and keep stepping
+        Pause // publish the cycle and pause, so a settled board costs no more work
+    };
+
+    /// @return The name of the action, as accepted by cycleActionParse.
+    [[nodiscard]] const char *cycleActionName(CycleAction action) noexcept;
+
+    /// @throws std::invalid_argument if the name is unknown.
+    [[nodiscard]] CycleAction cycleActionParse(std::string_view name);
+
+    /// A board that repeats: the board at generation start + period equals the one at start.
+    struct Cycle {
+        uint64_t period = 0; // 1 for a still life
+        uint64_t start = 0; // generation of the first board of the cycle
+
+        /// @return e.g. "still life since generation 120" or "period 2 since generation 87".
+        [[nodiscard]] std::string toString() const;
+    };
+
+    /**
+     * Finds cycles in a sequence of board hashes by remembering the last few of them.
+     *
+     * Fed the hash of every generation, the first repeat is found as soon as the cycle has gone round once, and
+     * its period and start are exact as long as the period fits in the history. Fed only every n-th generation,
+     * the period found is a multiple of n and of the real one.
+     *
+     * Boards are only compared by their 64 bit hash, so a cycle is reported falsely with a chance of about
+     * capacity / 2^64 per generation.
+     */
+    class CycleDetector {
+        struct Entry {
+            uint64_t hash;
+            uint64_t generation;
+        };
+
+        std::vector<Entry> m_History; // ring buffer
+        size_t m_Next = 0, m_Size = 0;
+        std::unordered_map<uint64_t, uint64_t> m_Index{}; // hash -> generation, of the entries in m_History
+        std::optional<Cycle> m_Cycle{};
+
+    public:
+        /// Longest period found by default, enough for all but a few engineered oscillators.
+        static constexpr size_t defaultCapacity = 4096;
+
+        /// @param capacity The number of hashes remembered, the longest period that can be found.
+        explicit CycleDetector(size_t capacity = defaultCapacity);
+
+        /**
+         * Record the hash of the board at a generation. Generations must increase between calls, unless reset.
+         * Once a cycle is found, further hashes are ignored, the board is periodic from then on.
+         * @return True if this hash completes the cycle.
+         */
+        bool push(uint64_t generation, uint64_t hash);
+
+        /// @return The cycle found, if any.
+        [[nodiscard]] const std::optional<Cycle> &cycle() const noexcept { return m_Cycle; }
+
+        /// Forget all hashes and the cycle, e.g. after the board was edited.
+        void reset() noexcept;
+    };
+}
+
+#endif //X11TEST_CYCLEDETECTOR_H
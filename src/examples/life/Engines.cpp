@@ -0,0 +1,29 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "Engines.h"
+
+#include <stdexcept>
+
+#include "BitEngine.h"
+#include "ByteEngine.h"
+#include "HashLifeEngine.h"
+#include "RuleEngine.h"
+
+namespace GameOfLife {
+    std::unique_ptr<LifeEngine> engineCreate(const EngineConfig &config) {
+        if (config.engine == "bytes") {
+            if (config.rule != ConwayRule::rule)
+                throw std::invalid_argument("The bytes engine only supports " + ConwayRule::rule.toString());
+            return std::make_unique<ByteEngine>(config.width, config.height);
+        }
+        if (config.engine == "bits")
+            return std::make_unique<BitEngine>(config.width, config.height, config.kernel, config.pool, config.rule);
+        if (config.engine == "hashlife")
+            return std::make_unique<HashLifeEngine>(config.width, config.height, config.memoryLimitMb << 20,
+                                                    config.rule);
+        if (config.engine == "rules") return std::make_unique<RuleEngine>(config.width, config.height, config.rule);
+        throw std::invalid_argument("Unknown engine " + config.engine);
+    }
+}
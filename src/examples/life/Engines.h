@@ -0,0 +1,34 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_ENGINES_H
+#define X11TEST_ENGINES_H
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "../../../core/lib/WorkStealingPool.h"
+#include "BitKernel.h"
+#include "LifeEngine.h"
+#include "LifeRule.h"
+
+namespace GameOfLife {
+    /// Runtime selection of a LifeEngine implementation.
+    struct EngineConfig {
+        std::string engine = "bits"; // "bytes", "bits", "hashlife" or "rules"
+        LifeRule rule{}; // "bytes" is Conway only, "bits" and "hashlife" take Life-like rules, "rules" any rule
+        Kernel kernel = Kernel::Auto; // only used by the bit-packed engines
+        int width = 20;
+        int height = 20;
+        size_t memoryLimitMb = 256; // node store size at which the hashlife engine collects garbage
+        X11App::WorkStealingPool *pool = nullptr; // pool the bit-packed engine steps tiles on, not owned
+    };
+
+    /// Create the engine described by the config.
+    /// @throws std::invalid_argument if the engine name is unknown, the dimensions are invalid or the engine does not
+    /// support the rule.
+    [[nodiscard]] std::unique_ptr<LifeEngine> engineCreate(const EngineConfig &config);
+}
+
+#endif //X11TEST_ENGINES_H
@@ -0,0 +1,412 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "HashLifeEngine.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace GameOfLife {
+    HashLifeEngine::HashLifeEngine(const int width, const int height, const size_t memoryLimitBytes,
+                                   const LifeRule &rule)
+        : m_Width(width), m_Height(height), m_Rule(rule), m_MemoryLimit(memoryLimitBytes) {
+        if (width <= 0 || height <= 0) throw std::invalid_argument("Board dimensions must be positive");
+        if (!rule.lifeLike() || rule.birth & 1)
+            throw std::invalid_argument("The hashlife engine only supports Life-like rules without B0, not " +
+                                        rule.toString());
+        reset();
+    }
+
+    size_t HashLifeEngine::hash(const NodeId nw, const NodeId ne, const NodeId sw, const NodeId se) noexcept {
+        constexpr uint64_t mul = 0x9E3779B97F4A7C15ull;
+        uint64_t h = nw;
+        h = h * mul + ne;
+        h = h * mul + sw;
+        h = h * mul + se;
+        return h ^ h >> 29;
+    }
+
+    void HashLifeEngine::tableInsert(const NodeId id) noexcept {
+        const Node &node = m_Nodes[id];
+        const size_t mask = m_Table.size() - 1;
+        size_t slot = hash(node.nw, node.ne, node.sw, node.se) & mask;
+        while (m_Table[slot] != noNode) slot = (slot + 1) & mask;
+        m_Table[slot] = id;
+    }
+
+    void HashLifeEngine::tableRebuild(const size_t slots) {
+        m_Table.assign(slots, noNode);
+        for (NodeId id = liveCell + 1; id < m_Nodes.size(); ++id)
+            if (!m_Nodes[id].free) tableInsert(id);
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::join(const NodeId nw, const NodeId ne, const NodeId sw, const NodeId se) {
+        // keep the load factor at or below 1/2
+        if ((m_Live + 1) * 2 > m_Table.size()) tableRebuild(m_Table.size() * 2);
+
+        const size_t mask = m_Table.size() - 1;
+        size_t slot = hash(nw, ne, sw, se) & mask;
+        for (; m_Table[slot] != noNode; slot = (slot + 1) & mask) {
+            const Node &node = m_Nodes[m_Table[slot]];
+            if (node.nw == nw && node.ne == ne && node.sw == sw && node.se == se) return m_Table[slot];
+        }
+
+        const auto level = static_cast<uint8_t>(m_Nodes[nw].level + 1);
+        NodeId id;
+        if (!m_FreeList.empty()) {
+            id = m_FreeList.back();
+            m_FreeList.pop_back();
+            m_Nodes[id] = {nw, ne, sw, se, noNode, level};
+        } else {
+            id = static_cast<NodeId>(m_Nodes.size());
+            m_Nodes.push_back({nw, ne, sw, se, noNode, level});
+        }
+        m_Table[slot] = id;
+
+        // collecting here would free the caller's unrooted temporaries, so only request it
+        if (++m_Live >= m_NodeLimit) m_CollectPending = true;
+        return id;
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::empty(const int level) {
+        while (static_cast<int>(m_Empty.size()) <= level) {
+            const NodeId below = m_Empty.back();
+            m_Empty.push_back(join(below, below, below, below));
+        }
+        return m_Empty[level];
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::expand(const NodeId node) {
+        const Node n = m_Nodes[node];
+        const NodeId e = empty(n.level - 1);
+        const NodeId nw = join(e, e, e, n.nw);
+        const NodeId ne = join(e, e, n.ne, e);
+        const NodeId sw = join(e, n.sw, e, e);
+        const NodeId se = join(n.se, e, e, e);
+        return join(nw, ne, sw, se);
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::centre(const NodeId node) {
+        const Node n = m_Nodes[node];
+        return join(m_Nodes[n.nw].se, m_Nodes[n.ne].sw, m_Nodes[n.sw].ne, m_Nodes[n.se].nw);
+    }
+
+    bool HashLifeEngine::centred(const NodeId node) const noexcept {
+        const Node &n = m_Nodes[node];
+        if (n.level < 2) return false;
+        const NodeId e = m_Empty[n.level - 2];
+        const Node &nw = m_Nodes[n.nw], &ne = m_Nodes[n.ne], &sw = m_Nodes[n.sw], &se = m_Nodes[n.se];
+        return nw.nw == e && nw.ne == e && nw.sw == e &&
+               ne.nw == e && ne.ne == e && ne.se == e &&
+               sw.nw == e && sw.sw == e && sw.se == e &&
+               se.ne == e && se.sw == e && se.se == e;
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::successorBase(const NodeId node) {
+        // gather the 4x4 cells into a 16 bit mask, bit y * 4 + x
+        unsigned cells = 0;
+        const Node n = m_Nodes[node];
+        const NodeId quadrants[4] = {n.nw, n.ne, n.sw, n.se};
+        for (int q = 0; q < 4; ++q) {
+            const Node &quad = m_Nodes[quadrants[q]];
+            const int qx = q % 2 * 2, qy = q / 2 * 2;
+            cells |= (quad.nw == liveCell) << (qy * 4 + qx);
+            cells |= (quad.ne == liveCell) << (qy * 4 + qx + 1);
+            cells |= (quad.sw == liveCell) << ((qy + 1) * 4 + qx);
+            cells |= (quad.se == liveCell) << ((qy + 1) * 4 + qx + 1);
+        }
+
+        NodeId next[4];
+        for (int i = 0; i < 4; ++i) {
+            const int x = 1 + i % 2, y = 1 + i / 2;
+            int liveNeighbors = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+                for (int dx = -1; dx <= 1; ++dx)
+                    if (dx != 0 || dy != 0) liveNeighbors += cells >> ((y + dy) * 4 + x + dx) & 1;
+            const bool alive = cells >> (y * 4 + x) & 1;
+            next[i] = (alive ? m_Rule.survive : m_Rule.birth) >> liveNeighbors & 1 ? liveCell : deadCell;
+        }
+        return join(next[0], next[1], next[2], next[3]);
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::successor(const NodeId node, const int step) {
+        const Node n = m_Nodes[node];
+        if (n.result != noNode && n.resultStep == step) {
+            m_Stats.memoHits++;
+            return n.result;
+        }
+        m_Stats.memoMisses++;
+
+        if (n.level == 2) {
+            const NodeId result = successorBase(node);
+            m_Nodes[node].result = result;
+            m_Nodes[node].resultStep = 0;
+            return result;
+        }
+
+        // every intermediate node goes onto m_Stack so a collection in a nested call keeps it alive
+        const size_t stackBase = m_Stack.size();
+        m_Stack.push_back(node);
+        if (m_CollectPending) collect();
+        const auto keep = [this](const NodeId id) {
+            m_Stack.push_back(id);
+            return id;
+        };
+
+        const Node nw = m_Nodes[n.nw], ne = m_Nodes[n.ne], sw = m_Nodes[n.sw], se = m_Nodes[n.se];
+
+        // the nine overlapping level - 1 nodes, row major
+        NodeId parts[9] = {
+            n.nw, keep(join(nw.ne, ne.nw, nw.se, ne.sw)), n.ne,
+            keep(join(nw.sw, nw.se, sw.nw, sw.ne)), keep(join(nw.se, ne.sw, sw.ne, se.nw)),
+            keep(join(ne.sw, ne.se, se.nw, se.ne)),
+            n.sw, keep(join(sw.ne, se.nw, sw.se, se.sw)), n.se
+        };
+
+        // full speed advances both halves by 2^(level - 3), slower steps only advance the second half
+        const bool fullSpeed = step == n.level - 2;
+        for (NodeId &part: parts) part = keep(fullSpeed ? successor(part, step - 1) : centre(part));
+
+        const int innerStep = fullSpeed ? step - 1 : step;
+        const NodeId quarters[4] = {
+            keep(join(parts[0], parts[1], parts[3], parts[4])), keep(join(parts[1], parts[2], parts[4], parts[5])),
+            keep(join(parts[3], parts[4], parts[6], parts[7])), keep(join(parts[4], parts[5], parts[7], parts[8]))
+        };
+        NodeId next[4];
+        for (int i = 0; i < 4; ++i) next[i] = keep(successor(quarters[i], innerStep));
+
+        const NodeId result = join(next[0], next[1], next[2], next[3]);
+        m_Stack.resize(stackBase);
+
+        m_Nodes[node].result = result;
+        m_Nodes[node].resultStep = static_cast<uint8_t>(step);
+        return result;
+    }
+
+    void HashLifeEngine::mark(const NodeId node) noexcept {
+        Node &n = m_Nodes[node];
+        if (n.marked || n.level == 0) return;
+        n.marked = true;
+        mark(n.nw);
+        mark(n.ne);
+        mark(n.sw);
+        mark(n.se);
+    }
+
+    void HashLifeEngine::collect() {
+        mark(m_Root);
+        for (const NodeId id: m_Empty) mark(id);
+        for (const NodeId id: m_Stack) mark(id);
+
+        for (NodeId id = liveCell + 1; id < m_Nodes.size(); ++id) {
+            Node &node = m_Nodes[id];
+            if (node.free || node.marked) continue;
+            node.free = true;
+            m_FreeList.push_back(id);
+            m_Live--;
+            m_Stats.freedNodes++;
+        }
+        for (NodeId id = liveCell + 1; id < m_Nodes.size(); ++id) {
+            Node &node = m_Nodes[id];
+            node.marked = false;
+            if (!node.free && node.result != noNode && m_Nodes[node.result].free) node.result = noNode;
+        }
+        tableRebuild(m_Table.size());
+
+        // if the reachable nodes alone are close to the limit, raise it instead of collecting on every step
+        const size_t baseLimit = m_MemoryLimit / (sizeof(Node) + 2 * sizeof(NodeId));
+        m_NodeLimit = std::max(baseLimit, m_Live * 2);
+        m_CollectPending = false;
+        m_Stats.collections++;
+    }
+
+    void HashLifeEngine::advance(const int step) {
+        if (step < 0 || step > maxLevel - 3) throw std::invalid_argument("Step exponent out of range");
+        if (m_CollectPending) collect();
+
+        // the pattern has to fit into the centre quarter, and one more ring leaves room for 2^step generations of
+        // growth at the speed of light
+        while (m_Nodes[m_Root].level < step + 2 || !centred(m_Root)) {
+            if (m_Nodes[m_Root].level >= maxLevel - 1) throw std::overflow_error("Pattern outgrew the universe");
+            m_Root = expand(m_Root);
+        }
+        m_Root = expand(m_Root);
+        m_Root = successor(m_Root, step);
+
+        // shrink again so lookups and the next expansion stay cheap
+        while (m_Nodes[m_Root].level > 3 && centred(m_Root)) m_Root = centre(m_Root);
+        m_Generation += uint64_t{1} << step;
+    }
+
+    void HashLifeEngine::reset() {
+        m_Nodes.clear();
+        m_Nodes.push_back({});
+        m_Nodes.push_back({});
+        m_FreeList.clear();
+        m_Stack.clear();
+        m_Live = 2;
+        m_Table.assign(1024, noNode);
+        m_Empty.assign(1, deadCell);
+        m_NodeLimit = std::max<size_t>(1024, m_MemoryLimit / (sizeof(Node) + 2 * sizeof(NodeId)));
+        m_CollectPending = false;
+        m_Stats = {};
+        m_Root = empty(3);
+        m_Generation = 0;
+    }
+
+    void HashLifeEngine::clear() noexcept {
+        reset();
+    }
+
+    HashLifeEngine::NodeId HashLifeEngine::setCell(const NodeId node, const int64_t x, const int64_t y,
+                                                   const bool alive) {
+        const Node n = m_Nodes[node];
+        if (n.level == 0) return alive ? liveCell : deadCell;
+
+        const int64_t half = int64_t{1} << (n.level - 1);
+        const bool east = x >= half, south = y >= half;
+        const int64_t cx = east ? x - half : x, cy = south ? y - half : y;
+        NodeId nw = n.nw, ne = n.ne, sw = n.sw, se = n.se;
+        NodeId &child = south ? (east ? se : sw) : (east ? ne : nw);
+        child = setCell(child, cx, cy, alive);
+        return join(nw, ne, sw, se);
+    }
+
+    void HashLifeEngine::set(const int x, const int y, const bool alive) {
+        // the root covers [-2^(level - 1), 2^(level - 1)) on both axes
+        const auto covers = [this](const int64_t v) {
+            const int64_t half = int64_t{1} << (m_Nodes[m_Root].level - 1);
+            return v >= -half && v < half;
+        };
+        while (!covers(x) || !covers(y)) m_Root = expand(m_Root);
+
+        const int64_t half = int64_t{1} << (m_Nodes[m_Root].level - 1);
+        m_Root = setCell(m_Root, x + half, y + half, alive);
+    }
+
+    bool HashLifeEngine::get(const int x, const int y) const noexcept {
+        NodeId node = m_Root;
+        int64_t half = int64_t{1} << (m_Nodes[node].level - 1);
+        int64_t lx = x + half, ly = y + half;
+        if (lx < 0 || ly < 0 || lx >= 2 * half || ly >= 2 * half) return false;
+
+        while (m_Nodes[node].level > 0) {
+            const Node &n = m_Nodes[node];
+            half = int64_t{1} << (n.level - 1);
+            const bool east = lx >= half, south = ly >= half;
+            node = south ? (east ? n.se : n.sw) : (east ? n.ne : n.nw);
+            if (east) lx -= half;
+            if (south) ly -= half;
+            // nothing lives below an empty node
+            if (node == m_Empty[std::min<size_t>(n.level - 1, m_Empty.size() - 1)]) return false;
+        }
+        return node == liveCell;
+    }
+
+    void HashLifeEngine::snapshotArea(BitBoard &out, const CellRect &area) const {
+        if (out.width() != area.width || out.height() != area.height) out = BitBoard(area.width, area.height);
+        else out.clear();
+
+        const int64_t right = int64_t{area.x} + area.width, bottom = int64_t{area.y} + area.height;
+        const auto copy = [&](const auto &self, const NodeId node, const int64_t x, const int64_t y) -> void {
+            const Node &n = m_Nodes[node];
+            const int64_t size = int64_t{1} << n.level;
+            if (x >= right || y >= bottom || x + size <= area.x || y + size <= area.y) return;
+            if (n.level == 0) {
+                if (node == liveCell) out.set(static_cast<int>(x - area.x), static_cast<int>(y - area.y), true);
+                return;
+            }
+            if (node == m_Empty[std::min<size_t>(n.level, m_Empty.size() - 1)]) return;
+
+            const int64_t half = size / 2;
+            self(self, n.nw, x, y);
+            self(self, n.ne, x + half, y);
+            self(self, n.sw, x, y + half);
+            self(self, n.se, x + half, y + half);
+        };
+        const int64_t half = int64_t{1} << (m_Nodes[m_Root].level - 1);
+        copy(copy, m_Root, -half, -half);
+    }
+
+    void HashLifeEngine::stepMany(const uint64_t generations) {
+        for (int bit = 0; bit < 64; ++bit)
+            if (generations >> bit & 1) advance(bit);
+    }
+
+    void HashLifeEngine::stepPow2(const int log2Generations) {
+        advance(log2Generations);
+    }
+
+    CellRect HashLifeEngine::extent() const {
+        // offset of the first or last live column (vertical false) or row of the root, -1 if it is empty. Shared
+        // nodes are searched once, and a node's far half only if its near half is empty.
+        const auto edge = [this](const bool vertical, const bool last) {
+            std::unordered_map<NodeId, int64_t> found;
+            const auto search = [&](const auto &self, const NodeId node) -> int64_t {
+                const Node &n = m_Nodes[node];
+                if (n.level == 0) return node == liveCell ? 0 : -1;
+                if (node == m_Empty[std::min<size_t>(n.level, m_Empty.size() - 1)]) return -1;
+                if (const auto it = found.find(node); it != found.end()) return it->second;
+
+                const auto pair = [&](const NodeId a, const NodeId b) {
+                    const int64_t first = self(self, a), second = self(self, b);
+                    if (first < 0 || second < 0) return std::max(first, second);
+                    return last ? std::max(first, second) : std::min(first, second);
+                };
+                const int64_t half = int64_t{1} << (n.level - 1);
+                const NodeId nearA = n.nw, nearB = vertical ? n.ne : n.sw;
+                const NodeId farA = vertical ? n.sw : n.ne, farB = n.se;
+                int64_t offset;
+                if (last) {
+                    offset = pair(farA, farB);
+                    offset = offset >= 0 ? offset + half : pair(nearA, nearB);
+                } else {
+                    offset = pair(nearA, nearB);
+                    if (offset < 0 && (offset = pair(farA, farB)) >= 0) offset += half;
+                }
+                found.emplace(node, offset);
+                return offset;
+            };
+            return search(search, m_Root);
+        };
+
+        const int64_t left = edge(false, false);
+        if (left < 0) return {0, 0, m_Width, m_Height};
+        const int64_t half = int64_t{1} << (m_Nodes[m_Root].level - 1);
+        constexpr int64_t intMin = INT32_MIN, intMax = INT32_MAX;
+        const int64_t firstX = std::clamp(left - half, intMin, intMax);
+        const int64_t firstY = std::clamp(edge(true, false) - half, intMin, intMax);
+        const int64_t lastX = std::clamp(edge(false, true) - half, intMin, intMax);
+        const int64_t lastY = std::clamp(edge(true, true) - half, intMin, intMax);
+        return {
+            static_cast<int>(firstX), static_cast<int>(firstY),
+            static_cast<int>(std::clamp(lastX - firstX + 1, int64_t{1}, intMax)),
+            static_cast<int>(std::clamp(lastY - firstY + 1, int64_t{1}, intMax))
+        };
+    }
+
+    uint64_t HashLifeEngine::population() const {
+        std::unordered_map<NodeId, uint64_t> counts;
+        const auto count = [&](const auto &self, const NodeId node) -> uint64_t {
+            const Node &n = m_Nodes[node];
+            if (n.level == 0) return node == liveCell;
+            if (node == m_Empty[std::min<size_t>(n.level, m_Empty.size() - 1)]) return 0;
+            if (const auto it = counts.find(node); it != counts.end()) return it->second;
+            const uint64_t total = self(self, n.nw) + self(self, n.ne) + self(self, n.sw) + self(self, n.se);
+            counts.emplace(node, total);
+            return total;
+        };
+        return count(count, m_Root);
+    }
+
+    HashLifeStats HashLifeEngine::stats() const noexcept {
+        HashLifeStats stats = m_Stats;
+        stats.nodes = m_Live;
+        stats.nodeLimit = m_NodeLimit;
+        stats.memoryBytes = m_Nodes.capacity() * sizeof(Node) + m_Table.size() * sizeof(NodeId);
+        stats.rootLevel = m_Nodes[m_Root].level;
+        return stats;
+    }
+}
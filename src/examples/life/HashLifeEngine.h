@@ -0,0 +1,150 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_HASHLIFEENGINE_H
+#define X11TEST_HASHLIFEENGINE_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "LifeEngine.h"
+
+namespace GameOfLife {
+    /// Counters of the HashLife node store.
+    struct HashLifeStats {
+        size_t nodes = 0; // live nodes in the store
+        size_t nodeLimit = 0; // node count that triggers the next collection
+        size_t memoryBytes = 0; // approximate size of the node store and its hash table
+        uint64_t memoHits = 0; // successor lookups answered from the cache
+        uint64_t memoMisses = 0;
+        uint64_t collections = 0;
+        uint64_t freedNodes = 0; // nodes freed by all collections
+        int rootLevel = 0; // the root covers 2^rootLevel x 2^rootLevel cells
+    };
+
+    /**
+     * HashLife engine on an unbounded plane.
+     *
+     * The universe is a quadtree of hash-consed nodes: a node of level k covers 2^k x 2^k cells and is identified by
+     * its four children, so identical regions anywhere in space and time share one node. Every node caches its
+     * successor, the centre half advanced by 2^j generations, which lets repetitive patterns jump over billions of
+     * generations in a handful of lookups.
+     *
+     * Nodes live in one array and are referenced by index. When the store grows past the memory limit, nodes
+     * unreachable from the root (and from the computation in progress) are freed and cached successors pointing at
+     * them are dropped.
+     */
+    class HashLifeEngine final : public LifeEngine {
+        using NodeId = uint32_t;
+        static constexpr NodeId noNode = ~NodeId{0};
+        static constexpr NodeId deadCell = 0, liveCell = 1; // the two level 0 nodes
+        static constexpr int maxLevel = 62;
+
+        struct Node {
+            NodeId nw = noNode, ne = noNode, sw = noNode, se = noNode;
+            NodeId result = noNode; // cached successor, valid if resultStep matches the requested step
+            uint8_t level = 0;
+            uint8_t resultStep = 0; // log2 of the generations the cached result is advanced by
+            bool marked = false; // collection mark, false outside of collect
+            bool free = false; // on the free list
+        };
+
+        int m_Width, m_Height;
+        LifeRule m_Rule;
+        uint64_t m_Generation = 0;
+        size_t m_MemoryLimit;
+        size_t m_NodeLimit = 0;
+
+        std::vector<Node> m_Nodes{};
+        std::vector<NodeId> m_FreeList{};
+        std::vector<NodeId> m_Table{}; // open addressing over m_Nodes, noNode marks an empty slot
+        size_t m_Live = 0;
+        std::vector<NodeId> m_Empty{}; // canonical empty node per level
+        std::vector<NodeId> m_Stack{}; // nodes of the computation in progress, roots for collect
+        NodeId m_Root = noNode;
+        bool m_CollectPending = false;
+        HashLifeStats m_Stats{};
+
+        [[nodiscard]] static size_t hash(NodeId nw, NodeId ne, NodeId sw, NodeId se) noexcept;
+
+        /// @return The canonical node with the given children, created if it does not exist yet.
+        NodeId join(NodeId nw, NodeId ne, NodeId sw, NodeId se);
+
+        [[nodiscard]] NodeId empty(int level);
+
+        void tableInsert(NodeId id) noexcept;
+
+        void tableRebuild(size_t slots);
+
+        /// @return A node one level up with node in its centre.
+        NodeId expand(NodeId node);
+
+        /// @return The centre of node, one level down.
+        NodeId centre(NodeId node);
+
+        /// @return True if all live cells of node are in its centre quarter.
+        [[nodiscard]] bool centred(NodeId node) const noexcept;
+
+        /// @return The centre half of a level 2 node advanced by one generation.
+        NodeId successorBase(NodeId node);
+
+        /// @return The centre half of node advanced by 2^step generations, step <= level - 2.
+        NodeId successor(NodeId node, int step);
+
+        NodeId setCell(NodeId node, int64_t x, int64_t y, bool alive);
+
+        void mark(NodeId node) noexcept;
+
+        /// Free all nodes unreachable from the root, m_Empty and m_Stack.
+        void collect();
+
+        /// Advance the root by 2^step generations.
+        void advance(int step);
+
+        void reset();
+
+    public:
+        /// @param width Width of the area of interest, cells outside of it are simulated as well.
+        /// @param height Height of the area of interest.
+        /// @param memoryLimitBytes Size of the node store at which unreachable nodes are collected.
+        /// @param rule A Life-like rule without birth on 0 neighbours, so the empty plane stays empty.
+        /// @throws std::invalid_argument if the dimensions or the rule are not supported.
+        HashLifeEngine(int width, int height, size_t memoryLimitBytes = size_t{256} << 20, const LifeRule &rule = {});
+
+        [[nodiscard]] const char *name() const noexcept override { return "hashlife"; }
+        [[nodiscard]] LifeRule rule() const noexcept override { return m_Rule; }
+        [[nodiscard]] int width() const noexcept override { return m_Width; }
+        [[nodiscard]] int height() const noexcept override { return m_Height; }
+        [[nodiscard]] bool bounded() const noexcept override { return false; }
+        [[nodiscard]] CellRect extent() const override;
+        [[nodiscard]] uint64_t generation() const noexcept override { return m_Generation; }
+        void setGeneration(const uint64_t generation) noexcept override { m_Generation = generation; }
+
+        [[nodiscard]] bool get(int x, int y) const noexcept override;
+
+        /// Grows the universe until it covers the cell, which allocates nodes.
+        void set(int x, int y, bool alive) override;
+
+        /// Descends only into the nodes overlapping the area that are not empty.
+        void snapshotArea(BitBoard &out, const CellRect &area) const override;
+
+        void clear() noexcept override;
+
+        void step() override { advance(0); }
+
+        /// Advance by the binary decomposition of generations, one 2^k jump per set bit.
+        void stepMany(uint64_t generations) override;
+
+        /// Advance by 2^log2Generations generations in a single jump.
+        /// @throws std::invalid_argument if log2Generations is too large for the universe.
+        void stepPow2(int log2Generations);
+
+        /// @return The number of live cells in the whole universe.
+        [[nodiscard]] uint64_t population() const;
+
+        [[nodiscard]] HashLifeStats stats() const noexcept;
+    };
+}
+
+#endif //X11TEST_HASHLIFEENGINE_H
@@ -0,0 +1,109 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_LIFEENGINE_H
+#define X11TEST_LIFEENGINE_H
+#include <cstdint>
+#include <vector>
+
+#include "BitBoard.h"
+#include "BoardHash.h"
+#include "LifeRule.h"
+
+namespace GameOfLife {
+    /// A rectangle in cell coordinates.
+    struct CellRect {
+        int x, y, width, height;
+    };
+
+    /**
+     * Stepping interface shared by all Game of Life engines, for Conway's rule unless they say otherwise. Engines
+     * are headless, so they can be benchmarked without a display. On bounded engines cells outside of
+     * [0, width) x [0, height) are dead and stay dead, unbounded engines simulate the whole plane and width/height
+     * only describe the area of interest.
+     */
+    class LifeEngine {
+    public:
+        virtual ~LifeEngine() = default;
+
+        /// @return A short name for logs and benchmark output.
+        [[nodiscard]] virtual const char *name() const noexcept = 0;
+
+        [[nodiscard]] virtual int width() const noexcept = 0;
+        [[nodiscard]] virtual int height() const noexcept = 0;
+
+        /// @return The rule the engine steps with.
+        [[nodiscard]] virtual LifeRule rule() const noexcept { return ConwayRule::rule; }
+
+        /// @return False if cells outside of width x height are simulated too.
+        [[nodiscard]] virtual bool bounded() const noexcept { return true; }
+
+        /// @return The area a copy of the whole board has to cover: [0, width) x [0, height) of bounded engines, the
+        /// bounding box of the live cells of unbounded ones, clipped to int coordinates, or [0, width) x [0, height)
+        /// if none is alive.
+        [[nodiscard]] virtual CellRect extent() const { return {0, 0, width(), height()}; }
+
+        /// @return The number of generations computed since construction or the last clear.
+        [[nodiscard]] virtual uint64_t generation() const noexcept = 0;
+
+        /// Continue counting from the given generation, e.g. after restoring a checkpoint.
+        virtual void setGeneration(uint64_t generation) noexcept = 0;
+
+        /// @return True if the cell is alive. Cells in the dying states of Generations rules are not. Out of range
+        /// coordinates of bounded engines are dead.
+        [[nodiscard]] virtual bool get(int x, int y) const noexcept = 0;
+
+        /// Set a single cell. Out of range coordinates of bounded engines are ignored.
+        /// @throws std::bad_alloc if an unbounded engine runs out of memory growing to reach the cell.
+        virtual void set(int x, int y, bool alive) = 0;
+
+        /// Set length cells along row y starting at x, e.g. a run of a pattern file. Engines that store rows
+        /// override this to write whole words at once.
+        /// @throws std::bad_alloc if an unbounded engine runs out of memory growing to reach the cells.
+        virtual void setSpan(const int x, const int y, const int length, const bool alive) {
+            for (int i = 0; i < length; ++i) set(x + i, y, alive);
+        }
+
+        /// Kill every cell and reset the generation counter.
+        virtual void clear() noexcept = 0;
+
+        /// Advance the board by one generation.
+        virtual void step() = 0;
+
+        /// Advance the board by the given number of generations. Engines that can skip ahead override this.
+        virtual void stepMany(const uint64_t generations) {
+            for (uint64_t i = 0; i < generations; ++i) step();
+        }
+
+        /// Append the areas that may have changed since the last call, by steps or set, and forget them.
+        /// Engines without change tracking report the whole board.
+        virtual void takeChangedAreas(std::vector<CellRect> &out) { out.push_back({0, 0, width(), height()}); }
+
+        /// Copy the cells of [0, width) x [0, height) into out, resizing it if the dimensions differ.
+        virtual void snapshot(BitBoard &out) const { snapshotArea(out, {0, 0, width(), height()}); }
+
+        /// Copy the cells of the area into out, cell (area.x, area.y) going to (0, 0), resizing it if the dimensions
+        /// differ. Unbounded engines override this to visit only the live parts of the area.
+        virtual void snapshotArea(BitBoard &out, const CellRect &area) const {
+            if (out.width() != area.width || out.height() != area.height) out = BitBoard(area.width, area.height);
+            else out.clear();
+            for (int y = 0; y < area.height; ++y)
+                for (int x = 0; x < area.width; ++x)
+                    if (get(area.x + x, area.y + y)) out.set(x, y, true);
+        }
+
+        /// @return boardHash of the cells in [0, width) x [0, height), equal boards have equal hashes across engines.
+        /// Engines with dying states add them with boardStateHash. This default copies the whole board, engines
+        /// that are tracked every generation override it to keep the hash up to date as they go.
+        [[nodiscard]] virtual uint64_t hash() {
+            BitBoard cells;
+            snapshot(cells);
+            return boardHash(cells);
+        }
+
+        void toggle(const int x, const int y) { set(x, y, !get(x, y)); }
+    };
+}
+
+#endif //X11TEST_LIFEENGINE_H
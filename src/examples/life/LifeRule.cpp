@@ -0,0 +1,128 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "LifeRule.h"
+
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <vector>
+
+namespace GameOfLife {
+    namespace {
+        [[noreturn]] void invalid(const std::string_view text, const std::string &reason) {
+            throw std::invalid_argument("Invalid rule " + std::string(text) + ": " + reason);
+        }
+
+        int parseNumber(const std::string_view text, const std::string_view number) {
+            int value = 0;
+            const auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), value);
+            if (number.empty() || error != std::errc{} || end != number.data() + number.size())
+                invalid(text, "expected a number, got \"" + std::string(number) + "\"");
+            return value;
+        }
+
+        /// Digits ("236") on the 8 cell neighbourhood, comma separated numbers and ranges ("2,5-12") otherwise.
+        uint64_t parseCounts(const std::string_view text, const std::string_view counts, const LifeRule &rule) {
+            uint64_t mask = 0;
+            const auto add = [&](const int first, const int last) {
+                if (first < 0 || last > rule.neighbours() || first > last)
+                    invalid(text, "counts must be in [0, " + std::to_string(rule.neighbours()) + "]");
+                for (int count = first; count <= last; ++count) mask |= uint64_t{1} << count;
+            };
+
+            if (rule.radius == 1 && counts.find_first_of(",-") == std::string_view::npos) {
+                for (const char digit: counts) {
+                    if (!std::isdigit(static_cast<unsigned char>(digit))) invalid(text, "counts must be digits");
+                    add(digit - '0', digit - '0');
+                }
+                return mask;
+            }
+
+            for (size_t start = 0; start < counts.size();) {
+                size_t end = counts.find(',', start);
+                if (end == std::string_view::npos) end = counts.size();
+                const std::string_view item = counts.substr(start, end - start);
+                const size_t dash = item.find('-');
+                if (dash == std::string_view::npos) add(parseNumber(text, item), parseNumber(text, item));
+                else add(parseNumber(text, item.substr(0, dash)), parseNumber(text, item.substr(dash + 1)));
+                start = end + 1;
+            }
+            return mask;
+        }
+
+        std::string countsToString(const uint64_t mask, const int radius) {
+            std::string out;
+            for (int count = 0; count < 64; ++count) {
+                if (!(mask >> count & 1)) continue;
+                if (radius == 1) {
+                    out += static_cast<char>('0' + count);
+                    continue;
+                }
+                int last = count;
+                while (last + 1 < 64 && mask >> (last + 1) & 1) last++;
+                if (!out.empty()) out += ',';
+                out += std::to_string(count);
+                if (last > count) out += '-' + std::to_string(last);
+                count = last;
+            }
+            return out;
+        }
+    }
+
+    std::string LifeRule::toString() const {
+        std::string out;
+        if (radius != 1) out += "R" + std::to_string(radius) + "/";
+        out += "B" + countsToString(birth, radius) + "/S" + countsToString(survive, radius);
+        if (states != 2) out += "/C" + std::to_string(states);
+        return out;
+    }
+
+    LifeRule LifeRule::parse(const std::string_view text) {
+        std::vector<std::string_view> parts;
+        for (size_t start = 0;;) {
+            const size_t end = text.find('/', start);
+            parts.push_back(text.substr(start, end - start));
+            if (end == std::string_view::npos) break;
+            start = end + 1;
+        }
+        const auto tag = [](const std::string_view part) {
+            return part.empty() ? '\0' : static_cast<char>(std::toupper(static_cast<unsigned char>(part[0])));
+        };
+
+        LifeRule rule{0, 0};
+        if (tag(parts.front()) == 'R') {
+            rule.radius = parseNumber(text, parts.front().substr(1));
+            if (rule.radius < 1 || rule.radius > maxRadius)
+                invalid(text, "the radius must be in [1, " + std::to_string(maxRadius) + "]");
+            parts.erase(parts.begin());
+        }
+
+        std::string_view birth, survive, states;
+        if (parts.size() >= 2 && tag(parts[0]) == 'B' && tag(parts[1]) == 'S') {
+            birth = parts[0].substr(1);
+            survive = parts[1].substr(1);
+        } else if (parts.size() >= 2 && tag(parts[0]) == 'S' && tag(parts[1]) == 'B') {
+            survive = parts[0].substr(1);
+            birth = parts[1].substr(1);
+        } else if (parts.size() >= 2 && tag(parts[0]) != 'B' && tag(parts[1]) != 'S') {
+            // the older survive/birth notation
+            survive = parts[0];
+            birth = parts[1];
+        } else {
+            invalid(text, "expected B<counts>/S<counts> or <survive>/<birth>");
+        }
+        if (parts.size() == 3) states = tag(parts[2]) == 'C' || tag(parts[2]) == 'G' ? parts[2].substr(1) : parts[2];
+        else if (parts.size() > 3) invalid(text, "too many parts");
+
+        rule.birth = parseCounts(text, birth, rule);
+        rule.survive = parseCounts(text, survive, rule);
+        if (!states.empty()) {
+            rule.states = parseNumber(text, states);
+            if (rule.states < 2 || rule.states > maxStates)
+                invalid(text, "the number of states must be in [2, " + std::to_string(maxStates) + "]");
+        }
+        return rule;
+    }
+}
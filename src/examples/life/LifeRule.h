@@ -0,0 +1,79 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_LIFERULE_H
+#define X11TEST_LIFERULE_H
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace GameOfLife {
+    /// @return A count mask with bit n set for every decimal digit n in digits, e.g. countMask("23") == 0b1100.
+    constexpr uint64_t countMask(const std::string_view digits) {
+        uint64_t mask = 0;
+        for (const char digit: digits) mask |= uint64_t{1} << (digit - '0');
+        return mask;
+    }
+
+    /**
+     * A Life-like rule on the Moore neighbourhood of the given radius.
+     *
+     * Bit n of birth/survive is set if a dead cell with n live neighbours is born, or a live cell with n live
+     * neighbours survives. With more than 2 states the rule is a Generations rule: a live cell that does not survive
+     * does not die right away but passes through states 2 .. states - 1, during which it is not counted as live and
+     * cannot be born again.
+     */
+    struct LifeRule {
+        static constexpr int maxRadius = 3; // (2 * 3 + 1)^2 - 1 = 48 neighbours still fit into the count masks
+        static constexpr int maxStates = 256;
+
+        uint64_t birth = countMask("3");
+        uint64_t survive = countMask("23");
+        int states = 2;
+        int radius = 1;
+
+        /// @return The number of cells in the neighbourhood, excluding the cell itself.
+        [[nodiscard]] constexpr int neighbours() const noexcept { return (2 * radius + 1) * (2 * radius + 1) - 1; }
+
+        /// @return True for two state rules on the 8 cell neighbourhood, which the bit-packed engines support.
+        [[nodiscard]] constexpr bool lifeLike() const noexcept { return states == 2 && radius == 1; }
+
+        /// Next state of a cell in state 0 (dead) or 1 (live) by live neighbour count, a Generations rule sends live
+        /// cells to 2 instead of 0.
+        /// @return The table, 2 rows of 64 counts.
+        [[nodiscard]] constexpr std::array<uint8_t, 128> table() const noexcept {
+            std::array<uint8_t, 128> next{};
+            for (int count = 0; count < 64; ++count) {
+                next[count] = birth >> count & 1;
+                next[64 + count] = survive >> count & 1 ? 1 : states > 2 ? 2 : 0;
+            }
+            return next;
+        }
+
+        /// @return The rule in the notation accepted by parse, e.g. "B3/S23", "B2/S/C3" or "R2/B7,8/S5-9".
+        [[nodiscard]] std::string toString() const;
+
+        /**
+         * Parse a rule. Accepts "B3/S23" and the older "23/3" (survive/birth), each optionally followed by "/C<n>"
+         * or "/<n>" for Generations rules, and preceded by "R<r>/" for larger neighbourhoods. Counts are digits, or
+         * comma separated numbers and ranges ("6,9-11") when the neighbourhood has more than 9 cells.
+         * @throws std::invalid_argument if the rule is malformed or out of range.
+         */
+        [[nodiscard]] static LifeRule parse(std::string_view text);
+
+        constexpr bool operator==(const LifeRule &other) const noexcept = default;
+    };
+
+    /// A rule fixed at compile time, for kernels specialised on it.
+    template<uint64_t Birth, uint64_t Survive>
+    struct StaticRule {
+        static constexpr LifeRule rule{Birth, Survive};
+        static constexpr auto table = rule.table();
+    };
+
+    using ConwayRule = StaticRule<countMask("3"), countMask("23")>;
+}
+
+#endif //X11TEST_LIFERULE_H
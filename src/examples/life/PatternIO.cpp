@@ -0,0 +1,497 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "PatternIO.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "../../../core/lib/MappedFile.h"
+
+namespace GameOfLife {
+    namespace {
+        // larger runs or coordinates do not fit a board, and the sum of two still fits an int
+        constexpr int maxCount = (1 << 30) - 1;
+        constexpr size_t rleLineLength = 70; // the line length other tools write and some expect
+        constexpr size_t writeBufferSize = size_t{1} << 20;
+
+        /// Parse errors carry the path and line, the line is only counted once something went wrong.
+        [[noreturn]] void malformed(const std::string &path, const std::string_view text, const size_t pos,
+                                    const std::string &reason) {
+            const auto line = std::count(text.begin(), text.begin() + static_cast<std::ptrdiff_t>(pos), '\n') + 1;
+            throw std::runtime_error(path + ":" + std::to_string(line) + ": " + reason);
+        }
+
+        [[nodiscard]] bool endsWith(const std::string &path, const std::string_view suffix) {
+            return path.size() >= suffix.size() &&
+                   std::equal(suffix.begin(), suffix.end(), path.end() - static_cast<std::ptrdiff_t>(suffix.size()),
+                              [](const char a, const char b) { return a == std::tolower(b); });
+        }
+
+        [[nodiscard]] size_t lineEnd(const std::string_view text, const size_t pos) noexcept {
+            const size_t end = text.find('\n', pos);
+            return end == std::string_view::npos ? text.size() : end;
+        }
+
+        [[nodiscard]] std::string_view trim(std::string_view text) noexcept {
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+            while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+            return text;
+        }
+
+        PatternFormat detect(const std::string &path, const std::string_view text) {
+            if (endsWith(path, ".rle")) return PatternFormat::Rle;
+            if (endsWith(path, ".cells")) return PatternFormat::Plaintext;
+
+            const std::string_view start = trim(text.substr(0, 64));
+            if (start.starts_with("#Life 1.06")) return PatternFormat::Life106;
+            if (start.starts_with("#Life")) throw std::runtime_error(path + ": only Life 1.06 is supported");
+            if (start.starts_with('!') || start.starts_with('O') || start.starts_with('.') || start.starts_with('*'))
+                return PatternFormat::Plaintext;
+            return PatternFormat::Rle;
+        }
+
+        /// Tracks the bounding box of the runs passed to the sink.
+        template<typename Sink>
+        struct Recorder {
+            PatternStats &stats;
+            Sink &sink;
+            int maxX = std::numeric_limits<int>::min(), maxY = std::numeric_limits<int>::min();
+
+            void operator()(const int x, const int y, const int length) {
+                if (stats.cells == 0) {
+                    stats.minX = x;
+                    stats.minY = y;
+                }
+                stats.minX = std::min(stats.minX, x);
+                stats.minY = std::min(stats.minY, y);
+                maxX = std::max(maxX, x + length);
+                maxY = std::max(maxY, y + 1);
+                stats.cells += static_cast<uint64_t>(length);
+                sink(x, y, length);
+            }
+
+            void finish() const noexcept {
+                if (stats.cells == 0) return;
+                stats.width = maxX - stats.minX;
+                stats.height = maxY - stats.minY;
+            }
+        };
+
+        /// @return The position of the comma that starts the next "key =" item of an RLE header line after pos, or
+        /// the end of the line. Values may contain commas themselves, e.g. some rule notations.
+        [[nodiscard]] size_t rleItemEnd(const std::string_view line, const size_t pos) noexcept {
+            for (size_t comma = line.find(',', pos); comma != std::string_view::npos;
+                 comma = line.find(',', comma + 1)) {
+                size_t i = comma + 1;
+                while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) i++;
+                const size_t keyStart = i;
+                while (i < line.size() && (std::isalnum(static_cast<unsigned char>(line[i])) || line[i] == '_')) i++;
+                if (i == keyStart) continue;
+                while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) i++;
+                if (i < line.size() && line[i] == '=') return comma;
+            }
+            return line.size();
+        }
+
+        /// The size and rule from the "x = 3, y = 3, rule = B3/S23" line of an RLE file.
+        struct RleHeader {
+            int width = 0, height = 0;
+            std::string rule{};
+            size_t bodyStart = 0;
+        };
+
+        RleHeader rleHeader(const std::string &path, const std::string_view text) {
+            RleHeader header;
+            size_t pos = 0;
+            while (pos < text.size()) {
+                const size_t end = lineEnd(text, pos);
+                const std::string_view line = trim(text.substr(pos, end - pos));
+                if (line.empty() || line.starts_with('#')) {
+                    pos = end + 1;
+                    continue;
+                }
+                if (!line.starts_with('x')) break;
+
+                for (size_t start = 0; start < line.size();) {
+                    const size_t comma = rleItemEnd(line, start);
+                    const std::string_view item = line.substr(start, comma - start);
+                    start = comma + 1;
+                    const size_t equals = item.find('=');
+                    if (equals == std::string_view::npos) malformed(path, text, pos, "expected key = value");
+                    const std::string_view key = trim(item.substr(0, equals)), value = trim(item.substr(equals + 1));
+                    if (key == "rule") {
+                        header.rule = value;
+                        continue;
+                    }
+                    int number = 0;
+                    const auto [last, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+                    if (key != "x" && key != "y") continue;
+                    if (error != std::errc{} || last != value.data() + value.size() || number < 0)
+                        malformed(path, text, pos, "invalid " + std::string(key));
+                    (key == "x" ? header.width : header.height) = number;
+                }
+                pos = end + 1;
+                break;
+            }
+            header.bodyStart = std::min(pos, text.size());
+            return header;
+        }
+
+        template<typename Sink>
+        void parseRle(const std::string &path, const std::string_view text, PatternStats &stats, Sink &&sink) {
+            const RleHeader header = rleHeader(path, text);
+            stats.rule = header.rule;
+
+            int x = 0, y = 0;
+            int count = 0; // 0 if no count was given, which means 1
+            for (size_t pos = header.bodyStart; pos < text.size(); ++pos) {
+                const char c = text[pos];
+                if (c >= '0' && c <= '9') {
+                    if (count > (maxCount - (c - '0')) / 10) malformed(path, text, pos, "run too long");
+                    count = count * 10 + (c - '0');
+                    continue;
+                }
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+
+                const int n = count == 0 ? 1 : count;
+                count = 0;
+                switch (c) {
+                    case 'o':
+                    case 'A':
+                        sink(x, y, n);
+                        x += n;
+                        break;
+                    case 'b':
+                    case '.':
+                        x += n;
+                        break;
+                    case '$':
+                        y += n;
+                        x = 0;
+                        break;
+                    case '!': return;
+                    case '#':
+                        pos = lineEnd(text, pos);
+                        break;
+                    default:
+                        // the dying states of Generations rules, "B" .. "X" and "pA" .. "yO", are not live
+                        if (c >= 'p' && c <= 'y' && pos + 1 < text.size()) ++pos;
+                        else if (c < 'B' || c > 'X')
+                            malformed(path, text, pos, "unexpected '" + std::string(1, c) + "'");
+                        x += n;
+                        break;
+                }
+                if (x > maxCount || y > maxCount) malformed(path, text, pos, "pattern too large");
+            }
+        }
+
+        template<typename Sink>
+        void parsePlaintext(const std::string &path, const std::string_view text, Sink &&sink) {
+            int y = 0;
+            for (size_t pos = 0; pos < text.size();) {
+                const size_t end = lineEnd(text, pos);
+                if (text[pos] == '!') {
+                    pos = end + 1;
+                    continue;
+                }
+                for (size_t i = pos; i < end;) {
+                    const char c = text[i];
+                    if (c == 'O' || c == '*') {
+                        const size_t first = i;
+                        while (i < end && (text[i] == 'O' || text[i] == '*')) ++i;
+                        sink(static_cast<int>(first - pos), y, static_cast<int>(i - first));
+                        continue;
+                    }
+                    if (c != '.' && c != '\r' && c != ' ')
+                        malformed(path, text, i, "unexpected '" + std::string(1, c) + "'");
+                    ++i;
+                }
+                if (end - pos > static_cast<size_t>(maxCount) || ++y > maxCount)
+                    malformed(path, text, pos, "pattern too large");
+                pos = end + 1;
+            }
+        }
+
+        template<typename Sink>
+        void parseLife106(const std::string &path, const std::string_view text, Sink &&sink) {
+            // horizontal neighbours are merged into runs, most files list cells row by row
+            int runX = 0, runY = 0, runLength = 0;
+            for (size_t pos = 0; pos < text.size();) {
+                const size_t end = lineEnd(text, pos);
+                const std::string_view line = trim(text.substr(pos, end - pos));
+                if (line.empty() || line.starts_with('#')) {
+                    pos = end + 1;
+                    continue;
+                }
+
+                int x = 0, y = 0;
+                const char *first = line.data(), *last = line.data() + line.size();
+                auto [afterX, errorX] = std::from_chars(first, last, x);
+                while (afterX != last && (*afterX == ' ' || *afterX == '\t')) ++afterX;
+                const auto [afterY, errorY] = std::from_chars(afterX, last, y);
+                if (errorX != std::errc{} || errorY != std::errc{} || afterY != last)
+                    malformed(path, text, pos, "expected \"x y\"");
+                if (std::abs(x) > maxCount || std::abs(y) > maxCount) malformed(path, text, pos, "pattern too large");
+
+                if (runLength > 0 && y == runY && x == runX + runLength) {
+                    runLength++;
+                } else {
+                    if (runLength > 0) sink(runX, runY, runLength);
+                    runX = x;
+                    runY = y;
+                    runLength = 1;
+                }
+                pos = end + 1;
+            }
+            if (runLength > 0) sink(runX, runY, runLength);
+        }
+
+        template<typename Sink>
+        void parse(const std::string &path, const std::string_view text, PatternStats &stats, Sink &&sink) {
+            Recorder<Sink> recorder{stats, sink};
+            switch (stats.format) {
+                case PatternFormat::Auto:
+                case PatternFormat::Rle: parseRle(path, text, stats, recorder);
+                    break;
+                case PatternFormat::Plaintext: parsePlaintext(path, text, recorder);
+                    break;
+                case PatternFormat::Life106: parseLife106(path, text, recorder);
+                    break;
+            }
+            recorder.finish();
+        }
+
+        /// Buffered output that only hits the file system every writeBufferSize bytes.
+        class Writer {
+            std::string m_Path;
+            std::unique_ptr<std::FILE, int (*)(std::FILE *)> m_File;
+            std::string m_Buffer{};
+            size_t m_Written = 0;
+
+        public:
+            explicit Writer(const std::string &path)
+                : m_Path(path), m_File(std::fopen(path.c_str(), "wb"), &std::fclose) {
+                if (!m_File) throw std::runtime_error("Failed to open " + path + " for writing");
+                m_Buffer.reserve(writeBufferSize);
+            }
+
+            void put(const std::string_view text) {
+                m_Buffer += text;
+                if (m_Buffer.size() >= writeBufferSize) flush();
+            }
+
+            void flush() {
+                if (std::fwrite(m_Buffer.data(), 1, m_Buffer.size(), m_File.get()) != m_Buffer.size())
+                    throw std::runtime_error("Failed to write " + m_Path);
+                m_Written += m_Buffer.size();
+                m_Buffer.clear();
+            }
+
+            /// @return The number of bytes written.
+            size_t close() {
+                flush();
+                if (std::fclose(m_File.release()) != 0) throw std::runtime_error("Failed to write " + m_Path);
+                return m_Written;
+            }
+        };
+
+        std::string number(const int64_t value) {
+            char digits[24];
+            const auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+            return {digits, end};
+        }
+
+        void writeRle(Writer &out, const BitBoard &cells, const PatternStats &stats, const LifeRule &rule) {
+            out.put("x = " + number(stats.width) + ", y = " + number(stats.height) + ", rule = " + rule.toString() +
+                    "\n");
+
+            size_t lineLength = 0;
+            const auto token = [&](const int count, const char tag) {
+                std::string text = count > 1 ? number(count) : std::string();
+                text += tag;
+                if (lineLength + text.size() > rleLineLength) {
+                    out.put("\n");
+                    lineLength = 0;
+                }
+                out.put(text);
+                lineLength += text.size();
+            };
+
+            int pendingRows = 0; // row ends not written yet, trailing empty rows are dropped
+            for (int y = stats.minY; y < stats.minY + stats.height; ++y) {
+                int x = stats.minX;
+                bitRuns(cells.row(y), cells.words(), [&](const int start, const int length) {
+                    if (pendingRows > 0) token(pendingRows, '$');
+                    pendingRows = 0;
+                    if (start > x) token(start - x, 'b');
+                    token(length, 'o');
+                    x = start + length;
+                });
+                pendingRows++;
+            }
+            token(1, '!');
+            out.put("\n");
+        }
+
+        void writePlaintext(Writer &out, const BitBoard &cells, const PatternStats &stats, const std::string &path) {
+            const size_t slash = path.find_last_of('/');
+            out.put("!Name: " + path.substr(slash == std::string::npos ? 0 : slash + 1) + "\n");
+            std::string line;
+            for (int y = stats.minY; y < stats.minY + stats.height; ++y) {
+                line.clear();
+                bitRuns(cells.row(y), cells.words(), [&](const int start, const int length) {
+                    line.append(static_cast<size_t>(start - stats.minX) - line.size(), '.');
+                    line.append(static_cast<size_t>(length), 'O');
+                });
+                if (line.empty()) line = ".";
+                line += '\n';
+                out.put(line);
+            }
+        }
+
+        void writeLife106(Writer &out, const BitBoard &cells) {
+            out.put("#Life 1.06\n");
+            for (int y = 0; y < cells.height(); ++y) {
+                bitRuns(cells.row(y), cells.words(), [&](const int start, const int length) {
+                    for (int x = start; x < start + length; ++x) {
+                        char line[32];
+                        char *end = std::to_chars(line, line + 12, x).ptr;
+                        *end++ = ' ';
+                        end = std::to_chars(end, line + sizeof(line), y).ptr;
+                        *end++ = '\n';
+                        out.put({line, end});
+                    }
+                });
+            }
+        }
+    }
+
+    const char *patternFormatName(const PatternFormat format) noexcept {
+        switch (format) {
+            case PatternFormat::Auto: return "auto";
+            case PatternFormat::Rle: return "rle";
+            case PatternFormat::Plaintext: return "plaintext";
+            case PatternFormat::Life106: return "life106";
+        }
+        return "unknown";
+    }
+
+    PatternFormat patternFormatParse(const std::string_view name) {
+        for (const PatternFormat format: {
+                 PatternFormat::Auto, PatternFormat::Rle, PatternFormat::Plaintext, PatternFormat::Life106
+             })
+            if (name == patternFormatName(format)) return format;
+        throw std::invalid_argument("Unknown pattern format " + std::string(name));
+    }
+
+    std::string PatternStats::toString() const {
+        return std::format("{}, {} cells ({}x{}), {:.1f} MiB in {:.1f} ms ({:.1f} MiB/s)", patternFormatName(format),
+                           cells, width, height, static_cast<double>(bytes) / (1 << 20), seconds * 1000,
+                           megabytesPerSecond());
+    }
+
+    PatternStats patternInspect(const std::string &path, const PatternFormat format) {
+        const auto start = std::chrono::steady_clock::now();
+        const X11App::MappedFile file(path);
+        PatternStats stats{.format = format == PatternFormat::Auto ? detect(path, file.view()) : format};
+        stats.bytes = file.size();
+        parse(path, file.view(), stats, [](int, int, int) {});
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    PatternStats patternLoad(LifeEngine &engine, const std::string &path, const int x, const int y,
+                             const PatternFormat format) {
+        const auto start = std::chrono::steady_clock::now();
+        const X11App::MappedFile file(path);
+        PatternStats stats{.format = format == PatternFormat::Auto ? detect(path, file.view()) : format};
+        stats.bytes = file.size();
+        parse(path, file.view(), stats, [&](const int cellX, const int cellY, const int length) {
+            engine.setSpan(x + cellX, y + cellY, length, true);
+        });
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    PatternStats patternPeek(const std::string &path, const PatternFormat format) {
+        // the size from an RLE header saves a pass over the file, other formats have to be read in full
+        const auto start = std::chrono::steady_clock::now();
+        const X11App::MappedFile file(path);
+        const PatternFormat detected = format == PatternFormat::Auto ? detect(path, file.view()) : format;
+        if (detected == PatternFormat::Rle) {
+            const RleHeader header = rleHeader(path, file.view());
+            if (header.width > 0 && header.height > 0) {
+                return {
+                    .format = detected, .bytes = file.size(), .width = header.width, .height = header.height,
+                    .rule = header.rule,
+                    .seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+                };
+            }
+        }
+        return patternInspect(path, detected);
+    }
+
+    PatternStats patternLoadCentred(LifeEngine &engine, const std::string &path, const PatternFormat format) {
+        return patternLoadCentred(engine, path, patternPeek(path, format));
+    }
+
+    PatternStats patternLoadCentred(LifeEngine &engine, const std::string &path, const PatternStats &peeked) {
+        return patternLoad(engine, path, (engine.width() - peeked.width) / 2 - peeked.minX,
+                           (engine.height() - peeked.height) / 2 - peeked.minY, peeked.format);
+    }
+
+    PatternStats patternSave(const BitBoard &cells, const std::string &path, PatternFormat format,
+                             const LifeRule &rule) {
+        const auto start = std::chrono::steady_clock::now();
+        if (format == PatternFormat::Auto) {
+            format = endsWith(path, ".cells") ? PatternFormat::Plaintext
+                     : endsWith(path, ".lif") || endsWith(path, ".life") ? PatternFormat::Life106
+                     : PatternFormat::Rle;
+        }
+
+        // bounding box of the live cells
+        PatternStats stats{.format = format};
+        int maxX = 0, maxY = 0;
+        for (int y = 0; y < cells.height(); ++y) {
+            bitRuns(cells.row(y), cells.words(), [&](const int x, const int length) {
+                if (stats.cells == 0) {
+                    stats.minX = x;
+                    stats.minY = y;
+                }
+                stats.minX = std::min(stats.minX, x);
+                maxX = std::max(maxX, x + length);
+                maxY = y + 1;
+                stats.cells += static_cast<uint64_t>(length);
+            });
+        }
+        if (stats.cells != 0) {
+            stats.width = maxX - stats.minX;
+            stats.height = maxY - stats.minY;
+        }
+        stats.rule = rule.toString();
+
+        Writer out(path);
+        switch (format) {
+            case PatternFormat::Auto:
+            case PatternFormat::Rle: writeRle(out, cells, stats, rule);
+                break;
+            case PatternFormat::Plaintext: writePlaintext(out, cells, stats, path);
+                break;
+            case PatternFormat::Life106: writeLife106(out, cells);
+                break;
+        }
+        stats.bytes = out.close();
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+}
@@ -0,0 +1,94 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_PATTERNIO_H
+#define X11TEST_PATTERNIO_H
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "BitBoard.h"
+#include "LifeEngine.h"
+#include "LifeRule.h"
+
+namespace GameOfLife {
+    enum class PatternFormat {
+        Auto, // by file extension, then by content
+        Rle, // run length encoded, .rle
+        Plaintext, // one character per cell, .cells
+        Life106 // one live cell coordinate per line, .lif / .life
+    };
+
+    /// @return The name of the format, as accepted by patternFormatParse.
+    [[nodiscard]] const char *patternFormatName(PatternFormat format) noexcept;
+
+    /// @throws std::invalid_argument if the name is unknown.
+    [[nodiscard]] PatternFormat patternFormatParse(std::string_view name);
+
+    /// What a pattern file holds and how long it took to read or write it.
+    struct PatternStats {
+        PatternFormat format = PatternFormat::Auto;
+        size_t bytes = 0;
+        uint64_t cells = 0; // live cells read or written
+        int minX = 0, minY = 0; // bounding box of the live cells, in file coordinates
+        int width = 0, height = 0;
+        std::string rule{}; // from the RLE header, empty if the file does not name one
+        double seconds = 0;
+
+        [[nodiscard]] double megabytesPerSecond() const noexcept {
+            return seconds > 0 ? static_cast<double>(bytes) / (1 << 20) / seconds : 0;
+        }
+
+        /// @return e.g. "rle, 1200 cells (30x40), 0.1 MiB in 2.5 ms (40.0 MiB/s)".
+        [[nodiscard]] std::string toString() const;
+    };
+
+    /**
+     * Read a pattern without placing it anywhere, e.g. to size the board or pick the rule before loading it.
+     * @throws std::runtime_error if the file cannot be read or is malformed.
+     */
+    [[nodiscard]] PatternStats patternInspect(const std::string &path, PatternFormat format = PatternFormat::Auto);
+
+    /**
+     * Like patternInspect, but an RLE file whose header gives its size is only read up to the header: cells stays
+     * 0 and the bounding box is the header's. Enough to size the board and centre the pattern, so loading the file
+     * afterwards is the only pass over its body.
+     * @throws std::runtime_error if the file cannot be read or is malformed.
+     */
+    [[nodiscard]] PatternStats patternPeek(const std::string &path, PatternFormat format = PatternFormat::Auto);
+
+    /**
+     * Load a pattern into the engine on top of its current cells. The file is memory mapped and parsed in one pass,
+     * every run of live cells goes straight into the board with LifeEngine::setSpan.
+     * @param engine The engine to write into, cells outside of bounded engines are dropped.
+     * @param path The pattern file.
+     * @param x Board column of file column 0.
+     * @param y Board row of file row 0.
+     * @param format The format, Auto to detect it.
+     * @throws std::runtime_error if the file cannot be read or is malformed. Cells before the error are kept.
+     */
+    PatternStats patternLoad(LifeEngine &engine, const std::string &path, int x, int y,
+                             PatternFormat format = PatternFormat::Auto);
+
+    /// Load a pattern centred on the board of the engine.
+    /// @throws std::runtime_error if the file cannot be read or is malformed.
+    PatternStats patternLoadCentred(LifeEngine &engine, const std::string &path,
+                                    PatternFormat format = PatternFormat::Auto);
+
+    /// Load a pattern centred on the board of the engine, using the format and bounding box of an earlier
+    /// patternPeek or patternInspect of the same file instead of reading it again.
+    /// @throws std::runtime_error if the file cannot be read or is malformed.
+    PatternStats patternLoadCentred(LifeEngine &engine, const std::string &path, const PatternStats &peeked);
+
+    /**
+     * Write the live cells of a board, cropped to their bounding box in RLE and plaintext. Life 1.06 keeps the
+     * board coordinates.
+     * @param format The format, Auto to pick it by the extension of path.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    PatternStats patternSave(const BitBoard &cells, const std::string &path,
+                             PatternFormat format = PatternFormat::Auto, const LifeRule &rule = {});
+}
+
+#endif //X11TEST_PATTERNIO_H
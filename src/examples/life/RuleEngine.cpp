@@ -0,0 +1,94 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "RuleEngine.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace GameOfLife {
+    RuleEngine::RuleEngine(const int width, const int height, const LifeRule &rule)
+        : m_Width(width), m_Height(height), m_Rule(rule), m_Table(rule.table()) {
+        if (width <= 0 || height <= 0) throw std::invalid_argument("Board dimensions must be positive");
+        if (rule.radius < 1 || rule.radius > LifeRule::maxRadius || rule.states < 2 ||
+            rule.states > LifeRule::maxStates)
+            throw std::invalid_argument("Rule out of range: " + rule.toString());
+        m_Cells.assign(static_cast<size_t>(width) * height, 0);
+        m_Next.assign(m_Cells.size(), 0);
+        m_RowCounts.assign(m_Cells.size(), 0);
+        m_Counts.assign(width, 0);
+    }
+
+    bool RuleEngine::get(const int x, const int y) const noexcept { return state(x, y) == 1; }
+
+    uint8_t RuleEngine::state(const int x, const int y) const noexcept {
+        if (x < 0 || x >= m_Width || y < 0 || y >= m_Height) return 0;
+        return m_Cells[index(x, y)];
+    }
+
+    void RuleEngine::set(const int x, const int y, const bool alive) noexcept {
+        if (x < 0 || x >= m_Width || y < 0 || y >= m_Height) return;
+        const uint8_t *row = &m_Cells[index(0, y)];
+        const size_t word = static_cast<size_t>(x) / 64;
+        m_Hash ^= byteWordHash(row, m_Width, y, word);
+        m_Cells[index(x, y)] = alive;
+        m_Hash ^= byteWordHash(row, m_Width, y, word);
+    }
+
+    void RuleEngine::clear() noexcept {
+        std::ranges::fill(m_Cells, 0);
+        m_Generation = 0;
+        m_Hash = 0;
+    }
+
+    void RuleEngine::step() {
+        const int r = m_Rule.radius;
+
+        // live cells in [x - r, x + r] of every row, sliding the window along the row
+        for (int y = 0; y < m_Height; ++y) {
+            const uint8_t *row = &m_Cells[index(0, y)];
+            uint8_t *counts = &m_RowCounts[index(0, y)];
+            int window = 0;
+            for (int x = 0; x < std::min(r, m_Width); ++x) window += row[x] == 1;
+            for (int x = 0; x < m_Width; ++x) {
+                if (x + r < m_Width) window += row[x + r] == 1;
+                if (x - r - 1 >= 0) window -= row[x - r - 1] == 1;
+                counts[x] = static_cast<uint8_t>(window);
+            }
+        }
+
+        // then the rows [y - r, y + r] of those sums, sliding the window down the columns
+        std::ranges::fill(m_Counts, 0);
+        for (int y = 0; y < std::min(r, m_Height); ++y)
+            for (int x = 0; x < m_Width; ++x) m_Counts[x] += m_RowCounts[index(x, y)];
+
+        const int states = m_Rule.states;
+        uint64_t hash = 0;
+        for (int y = 0; y < m_Height; ++y) {
+            if (y + r < m_Height)
+                for (int x = 0; x < m_Width; ++x) m_Counts[x] += m_RowCounts[index(x, y + r)];
+            if (y - r - 1 >= 0)
+                for (int x = 0; x < m_Width; ++x) m_Counts[x] -= m_RowCounts[index(x, y - r - 1)];
+
+            const uint8_t *row = &m_Cells[index(0, y)];
+            uint8_t *next = &m_Next[index(0, y)];
+            for (int x = 0; x < m_Width; ++x) {
+                const uint8_t state = row[x];
+                if (state >= 2) {
+                    // dying cells age regardless of their neighbours
+                    next[x] = state + 1 == states ? 0 : static_cast<uint8_t>(state + 1);
+                } else {
+                    // the window includes the cell itself
+                    next[x] = m_Table[state * 64 + m_Counts[x] - state];
+                }
+            }
+            // while the row is still in cache
+            hash ^= byteRowHash(next, m_Width, y);
+        }
+
+        m_Cells.swap(m_Next);
+        m_Hash = hash;
+        m_Generation++;
+    }
+}
@@ -0,0 +1,64 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_RULEENGINE_H
+#define X11TEST_RULEENGINE_H
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "LifeEngine.h"
+#include "LifeRule.h"
+
+namespace GameOfLife {
+    /**
+     * Engine for any LifeRule, including Generations rules and neighbourhoods of radius > 1, which the bit-packed
+     * engines do not cover. One byte per cell holds its state, the next state is looked up by state and neighbour
+     * count in the table of the rule.
+     *
+     * Neighbours are counted with a sliding window, first along each row and then down the columns, so the cost per
+     * cell does not grow with the radius.
+     */
+    class RuleEngine final : public LifeEngine {
+        int m_Width, m_Height;
+        LifeRule m_Rule;
+        std::array<uint8_t, 128> m_Table;
+        uint64_t m_Generation = 0;
+        uint64_t m_Hash = 0; // byteRowHash of all rows, updated by step and set
+        std::vector<uint8_t> m_Cells, m_Next; // row major states
+        std::vector<uint8_t> m_RowCounts; // live cells within the radius along each row, the cell itself included
+        std::vector<uint8_t> m_Counts; // the column sums of m_RowCounts for the current row
+
+        [[nodiscard]] size_t index(const int x, const int y) const noexcept {
+            return static_cast<size_t>(y) * m_Width + x;
+        }
+
+    public:
+        /// @throws std::invalid_argument if the dimensions are not positive or the rule is out of range.
+        RuleEngine(int width, int height, const LifeRule &rule);
+
+        [[nodiscard]] const char *name() const noexcept override { return "rules"; }
+        [[nodiscard]] LifeRule rule() const noexcept override { return m_Rule; }
+        [[nodiscard]] int width() const noexcept override { return m_Width; }
+        [[nodiscard]] int height() const noexcept override { return m_Height; }
+        [[nodiscard]] uint64_t generation() const noexcept override { return m_Generation; }
+        void setGeneration(const uint64_t generation) noexcept override { m_Generation = generation; }
+
+        [[nodiscard]] bool get(int x, int y) const noexcept override;
+
+        /// Set a cell live or dead, which also ends its dying states.
+        void set(int x, int y, bool alive) noexcept override;
+
+        void clear() noexcept override;
+
+        [[nodiscard]] uint64_t hash() noexcept override { return m_Hash; }
+
+        void step() override;
+
+        /// @return The state of the cell: 0 dead, 1 live, 2 and up dying. Out of range cells are dead.
+        [[nodiscard]] uint8_t state(int x, int y) const noexcept;
+    };
+}
+
+#endif //X11TEST_RULEENGINE_H
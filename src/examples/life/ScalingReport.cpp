@@ -0,0 +1,54 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "ScalingReport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "BitEngine.h"
+
+namespace GameOfLife {
+    void scalingReport(std::ostream &out, const ScalingConfig &config) {
+        // checked before the table header, which would be left without rows otherwise
+        if (!config.rule.lifeLike())
+            throw std::invalid_argument("The scaling report needs a Life-like rule, not " + config.rule.toString());
+        const unsigned maxThreads = config.maxThreads != 0
+                                        ? config.maxThreads
+                                        : std::max(1u, std::thread::hardware_concurrency());
+
+        out << std::format("{}x{} cells, {} generations, kernel {}, rule {}{}\n", config.width, config.height,
+                           config.generations, kernelName(kernelResolve(config.kernel)), config.rule.toString(),
+                           kernelSpecialised(config.rule) ? "" : " (generic kernel)");
+        out << std::format("{:>7} {:>10} {:>8} {:>10} {:>7}\n", "threads", "ms/gen", "speedup", "efficiency",
+                           "steals");
+
+        double baseMs = 0;
+        for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+            X11App::WorkStealingPool pool(threads);
+            BitEngine engine(config.width, config.height, config.kernel, &pool, config.rule);
+
+            // same soup for every thread count
+            std::mt19937 rng(config.seed);
+            for (int y = 0; y < config.height; ++y)
+                for (int x = 0; x < config.width; ++x)
+                    if (rng() % 4 == 0) engine.set(x, y, true);
+            engine.step();
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < config.generations; ++i) engine.step();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+            const double ms = elapsed.count() / config.generations;
+            if (threads == 1) baseMs = ms;
+            const double speedup = baseMs / ms;
+            out << std::format("{:>7} {:>10.3f} {:>8.2f} {:>9.0f}% {:>7}\n", threads, ms, speedup,
+                               100 * speedup / threads, pool.stats().steals);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_SCALINGREPORT_H
+#define X11TEST_SCALINGREPORT_H
+#include <cstdint>
+#include <ostream>
+
+#include "BitKernel.h"
+#include "LifeRule.h"
+
+namespace GameOfLife {
+    struct ScalingConfig {
+        int width = 8192;
+        int height = 8192;
+        int generations = 50;
+        unsigned maxThreads = 0; // 0 measures up to one thread per hardware thread
+        Kernel kernel = Kernel::Auto;
+        LifeRule rule{}; // Life-like
+        uint32_t seed = 1;
+    };
+
+    /// Step a random board of the bit-packed engine on pools of 1..maxThreads workers and write a table of
+    /// time per generation, speedup and parallel efficiency. Runs headless.
+    /// @throws std::invalid_argument if the rule is not Life-like, the bit-packed engine only steps those.
+    void scalingReport(std::ostream &out, const ScalingConfig &config);
+}
+
+#endif //X11TEST_SCALINGREPORT_H
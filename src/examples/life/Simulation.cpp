@@ -0,0 +1,199 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#include "Simulation.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "../../../core/lib/Profiler.h"
+
+namespace GameOfLife {
+    Simulation::Simulation(LifeEngine &engine, const std::chrono::milliseconds interval,
+                           std::function<void()> onPublish, std::function<void(const LifeEngine &)> onCapture)
+        : m_Engine(engine), m_Interval(interval), m_OnPublish(std::move(onPublish)), m_OnCapture(std::move(onCapture)),
+          m_Window{0, 0, engine.width(), engine.height()} {
+    }
+
+    void Simulation::start() {
+        if (m_Thread.joinable()) return;
+        {
+            std::lock_guard lock(m_WakeMutex);
+            m_Stop = false;
+        }
+        m_Thread = std::thread(&Simulation::loop, this);
+    }
+
+    void Simulation::stop() {
+        if (!m_Thread.joinable()) return;
+        {
+            std::lock_guard lock(m_WakeMutex);
+            m_Stop = true;
+        }
+        m_Wake.notify_one();
+        m_Thread.join();
+    }
+
+    void Simulation::push(const Command &command) {
+        // the queue only fills up if the simulation thread is stuck in a long step, wait for it to catch up
+        while (!m_Commands.tryPush(command)) std::this_thread::yield();
+        m_CommandsSent++;
+        {
+            std::lock_guard lock(m_WakeMutex);
+            m_WakePending = true;
+        }
+        m_Wake.notify_one();
+    }
+
+    const LifeSnapshot *Simulation::acquire() noexcept {
+        if (!m_Snapshots.update()) return nullptr;
+        m_Taken.store(true, std::memory_order_release);
+        return &m_Snapshots.front();
+    }
+
+    void Simulation::apply(const Command &command) {
+        m_CommandsApplied++;
+        // whatever the command was, the UI asked for it after the pause and must not follow the pause anymore
+        m_PausedOnCycle = false;
+        switch (command.type) {
+            case Command::Type::Toggle: m_Engine.toggle(command.x, command.y);
+                // the edited board starts a new history
+                m_Cycles.reset();
+                cycleTrack();
+                break;
+            case Command::Type::SetMode: m_Mode = static_cast<SimulationMode>(command.value);
+                break;
+            case Command::Type::SetStepLog2: m_StepLog2 = static_cast<int>(command.value);
+                break;
+            case Command::Type::FastForward: m_FastForward += command.value;
+                break;
+            case Command::Type::SetCycleAction: m_CycleAction = static_cast<CycleAction>(command.value);
+                m_Cycles.reset();
+                cycleTrack();
+                break;
+            case Command::Type::SetWindow:
+                m_Window = {
+                    command.x, command.y, static_cast<int>(command.value >> 32),
+                    static_cast<int>(command.value & 0xffffffff)
+                };
+                break;
+            case Command::Type::Capture: if (m_OnCapture) m_OnCapture(m_Engine);
+                break;
+        }
+    }
+
+    void Simulation::publish() {
+        PROFILE_ZONE("publish");
+        LifeSnapshot &snapshot = m_Snapshots.back();
+        snapshot.changed.clear();
+        if (m_Engine.bounded()) {
+            m_Engine.snapshot(snapshot.cells);
+            snapshot.originX = snapshot.originY = 0;
+            m_Engine.takeChangedAreas(snapshot.changed);
+        } else {
+            // the plane has no end, only the window the renderer asked for is copied, and all of it may have changed
+            m_Engine.snapshotArea(snapshot.cells, m_Window);
+            snapshot.originX = m_Window.x;
+            snapshot.originY = m_Window.y;
+            snapshot.changed.push_back(m_Window);
+        }
+        snapshot.generation = m_Engine.generation();
+        snapshot.sequence = ++m_Sequence;
+        snapshot.generationsPerSecond = m_Rate;
+        snapshot.commands = m_CommandsApplied;
+        snapshot.pausedOnCycle = m_PausedOnCycle;
+        snapshot.cycle = m_Cycles.cycle();
+
+        m_Taken.store(false, std::memory_order_relaxed);
+        m_Snapshots.publish();
+        if (m_OnPublish) m_OnPublish();
+    }
+
+    void Simulation::cycleTrack() {
+        if (m_CycleAction == CycleAction::Ignore || !m_Engine.bounded()) return;
+        if (m_Cycles.push(m_Engine.generation(), m_Engine.hash()) && m_CycleAction == CycleAction::Pause &&
+            m_Mode != SimulationMode::Paused) {
+            m_Mode = SimulationMode::Paused;
+            m_PausedOnCycle = true;
+        }
+    }
+
+    void Simulation::loop() {
+        using Clock = std::chrono::steady_clock;
+
+        auto nextStep = Clock::now() + m_Interval;
+        auto lastPublish = Clock::now();
+        auto rateStart = lastPublish;
+        uint64_t rateGeneration = m_Engine.generation();
+        bool dirty = true; // the initial board has not been published yet
+        PROFILE_THREAD("simulation");
+        cycleTrack();
+
+        while (true) {
+            Command command{};
+            while (m_Commands.tryPop(command)) {
+                apply(command);
+                dirty = true;
+            }
+
+            // steps of 2^m_StepLog2 generations, fast forwarding unbounded engines in a single call since they
+            // jump ahead instead of stepping
+            const uint64_t stepSize = uint64_t{1} << m_StepLog2;
+            auto now = Clock::now();
+            if (const auto &cycle = m_Cycles.cycle(); m_FastForward > 0 && cycle) {
+                // whole periods bring the board back to where it is
+                const uint64_t skip = m_FastForward - m_FastForward % cycle->period;
+                m_Engine.setGeneration(m_Engine.generation() + skip);
+                m_FastForward -= skip;
+                dirty = true;
+            }
+            if (m_FastForward > 0) {
+                const uint64_t generations = m_Engine.bounded() ? std::min(m_FastForward, stepSize) : m_FastForward;
+                PROFILE_ZONE("step");
+                m_Engine.stepMany(generations);
+                m_FastForward -= generations;
+                cycleTrack();
+                dirty = true;
+            } else if (m_Mode == SimulationMode::MaxSpeed) {
+                PROFILE_ZONE("step");
+                m_Engine.stepMany(stepSize);
+                cycleTrack();
+                dirty = true;
+            } else if (m_Mode == SimulationMode::Interval && now >= nextStep) {
+                PROFILE_ZONE("step");
+                m_Engine.stepMany(stepSize);
+                cycleTrack();
+                // a step that took longer than the interval delays the next one instead of queueing up more
+                nextStep = std::max(nextStep + m_Interval, now);
+                dirty = true;
+            }
+
+            now = Clock::now();
+            if (now - rateStart >= std::chrono::milliseconds(500)) {
+                const std::chrono::duration<double> elapsed = now - rateStart;
+                m_Rate = static_cast<double>(m_Engine.generation() - rateGeneration) / elapsed.count();
+                rateStart = now;
+                rateGeneration = m_Engine.generation();
+            }
+
+            // while running flat out, only copy the board when the renderer is ready for it
+            const bool busy = m_FastForward > 0 || m_Mode == SimulationMode::MaxSpeed;
+            const bool rendererReady = m_Taken.load(std::memory_order_acquire) && now - lastPublish >= publishInterval;
+            if (dirty && (!busy || rendererReady)) {
+                publish();
+                lastPublish = now;
+                dirty = false;
+            }
+
+            std::unique_lock lock(m_WakeMutex);
+            if (m_Stop) return;
+            if (busy) continue;
+            const auto woken = [this] { return m_WakePending || m_Stop; };
+            if (m_Mode == SimulationMode::Interval) m_Wake.wait_until(lock, nextStep, woken);
+            else m_Wake.wait(lock, woken);
+            m_WakePending = false;
+            if (m_Stop) return;
+        }
+    }
+}
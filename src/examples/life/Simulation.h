@@ -0,0 +1,168 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_SIMULATION_H
+#define X11TEST_SIMULATION_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "../../../core/lib/SpscRing.h"
+#include "../../../core/lib/TripleBuffer.h"
+#include "BitBoard.h"
+#include "CycleDetector.h"
+#include "LifeEngine.h"
+
+namespace GameOfLife {
+    enum class SimulationMode {
+        Paused,
+        Interval, // one step per interval
+        MaxSpeed // steps back to back
+    };
+
+    /// Immutable state of the board handed from the simulation thread to the renderer.
+    struct LifeSnapshot {
+        BitBoard cells{}; // [0, width) x [0, height) of a bounded engine, the requested window of an unbounded one
+        int originX = 0, originY = 0; // engine coordinates of cells(0, 0)
+        uint64_t generation = 0;
+        uint64_t sequence = 0; // incremented per snapshot, a gap means the renderer missed one
+        std::vector<CellRect> changed{}; // areas changed since the previous snapshot, in engine coordinates
+        double generationsPerSecond = 0;
+        uint64_t commands = 0; // commands the simulation had applied, compare with Simulation::commandsSent
+        bool pausedOnCycle = false; // paused itself on CycleAction::Pause, and no command was applied since
+        std::optional<Cycle> cycle{}; // once the board repeats
+    };
+
+    /**
+     * Runs a LifeEngine on its own thread, so the UI frame rate does not depend on the cost of a generation.
+     *
+     * The UI thread sends edits and mode changes through a lock-free command queue and picks up the newest board
+     * with acquire(), which never blocks. Snapshots are published through a triple buffer, at most about once per
+     * frame of the renderer while the simulation is running flat out, and right away otherwise. Unbounded engines have
+     * no board to copy, they are snapshotted within the window the UI sets with setWindow.
+     *
+     * The hash of every generation of a bounded engine goes into a CycleDetector, so a board that settled into a
+     * still life or oscillator is noticed and, depending on the CycleAction, the simulation pauses itself. Fast
+     * forwarding a known cycle skips whole periods without stepping. Unbounded engines are not tracked, their
+     * hash only covers part of the plane.
+     *
+     * Once started, the engine must only be touched by the simulation thread.
+     */
+    class Simulation {
+        struct Command {
+            enum class Type { Toggle, SetMode, SetStepLog2, FastForward, SetCycleAction, SetWindow, Capture } type;
+            int x = 0, y = 0;
+            uint64_t value = 0;
+        };
+
+        /// Minimum time between two snapshots while stepping back to back.
+        static constexpr auto publishInterval = std::chrono::milliseconds(8);
+
+        LifeEngine &m_Engine;
+        std::chrono::milliseconds m_Interval;
+        std::function<void()> m_OnPublish;
+        std::function<void(const LifeEngine &)> m_OnCapture;
+
+        X11App::SpscRing<Command, 256> m_Commands{};
+        uint64_t m_CommandsSent = 0; // UI thread only
+        X11App::TripleBuffer<LifeSnapshot> m_Snapshots{};
+        std::atomic<bool> m_Taken{true}; // the renderer took the last published snapshot
+
+        std::thread m_Thread{};
+        std::mutex m_WakeMutex{};
+        std::condition_variable m_Wake{};
+        bool m_WakePending = false; // guarded by m_WakeMutex
+        bool m_Stop = false; // guarded by m_WakeMutex
+
+        // simulation thread only
+        SimulationMode m_Mode = SimulationMode::Paused;
+        int m_StepLog2 = 0;
+        uint64_t m_FastForward = 0; // generations left to fast forward
+        uint64_t m_Sequence = 0;
+        uint64_t m_CommandsApplied = 0;
+        bool m_PausedOnCycle = false;
+        double m_Rate = 0;
+        CycleAction m_CycleAction = CycleAction::Report;
+        CycleDetector m_Cycles{};
+        CellRect m_Window; // the cells snapshotted of an unbounded engine
+
+        void push(const Command &command);
+
+        void apply(const Command &command);
+
+        void publish();
+
+        /// Feed the hash of the current generation to the cycle detector and act on a cycle it completes.
+        void cycleTrack();
+
+        void loop();
+
+    public:
+        /// @param engine The engine to run, must outlive the simulation.
+        /// @param interval Time between steps in SimulationMode::Interval.
+        /// @param onPublish Called on the simulation thread after every published snapshot, e.g. to wake the UI.
+        /// @param onCapture Called with the engine on the simulation thread for every capture().
+        Simulation(LifeEngine &engine, std::chrono::milliseconds interval, std::function<void()> onPublish = {},
+                   std::function<void(const LifeEngine &)> onCapture = {});
+
+        Simulation(const Simulation &) = delete;
+        Simulation &operator=(const Simulation &) = delete;
+
+        ~Simulation() { stop(); }
+
+        /// Start the simulation thread and publish the initial board. Does nothing if it is running.
+        void start();
+
+        /// Stop and join the simulation thread. Does nothing if it is not running.
+        void stop();
+
+        void toggle(int x, int y) { push({Command::Type::Toggle, x, y}); }
+
+        void setMode(const SimulationMode mode) { push({Command::Type::SetMode, 0, 0, static_cast<uint64_t>(mode)}); }
+
+        /// Advance 2^log2Generations generations per step.
+        void setStepLog2(const int log2Generations) {
+            push({Command::Type::SetStepLog2, 0, 0, static_cast<uint64_t>(log2Generations)});
+        }
+
+        /// Advance the given number of generations as fast as possible, on top of the current mode.
+        void fastForward(const uint64_t generations) { push({Command::Type::FastForward, 0, 0, generations}); }
+
+        /// What to do once the board repeats itself, CycleAction::Report by default.
+        void setCycleAction(const CycleAction action) {
+            push({Command::Type::SetCycleAction, 0, 0, static_cast<uint64_t>(action)});
+        }
+
+        /// Snapshot the area instead of [0, width) x [0, height) of an unbounded engine, e.g. the cells in view.
+        /// Bounded engines are always snapshotted whole.
+        void setWindow(const CellRect &area) {
+            push({
+                Command::Type::SetWindow, area.x, area.y,
+                static_cast<uint64_t>(static_cast<uint32_t>(area.width)) << 32 | static_cast<uint32_t>(area.height)
+            });
+        }
+
+        /// Hand the engine to onCapture between two steps, e.g. to copy more of an unbounded engine than a snapshot
+        /// holds.
+        void capture() { push({Command::Type::Capture}); }
+
+        /// UI thread only.
+        /// @return The number of commands sent so far. A snapshot with as many LifeSnapshot::commands reflects all
+        /// of them, so its pausedOnCycle cannot be undone by a command still in flight.
+        [[nodiscard]] uint64_t commandsSent() const noexcept { return m_CommandsSent; }
+
+        /// UI thread only.
+        /// @return The newest snapshot if one was published since the last call, nullptr otherwise. Valid until the
+        /// next call that returns a snapshot.
+        [[nodiscard]] const LifeSnapshot *acquire() noexcept;
+    };
+}
+
+#endif //X11TEST_SIMULATION_H
@@ -0,0 +1,83 @@
+//
+// Created by julian on 10/17/26.
+//
+
+#ifndef X11TEST_VIEWPORT_H
+#define X11TEST_VIEWPORT_H
+#include <algorithm>
+#include <cmath>
+
+#include "LifeEngine.h"
+
+namespace GameOfLife {
+    /**
+     * Maps board cells to window pixels. Cell (x, y) covers the pixels [screenX(x), screenX(x + 1)) horizontally,
+     * so neighbouring cells share their edge and no pixels are lost to rounding at any zoom.
+     */
+    struct Viewport {
+        static constexpr double minCellSize = 1.0 / 1024; // 1024 x 1024 cells per pixel
+        static constexpr double maxCellSize = 128;
+
+        double originX = 0, originY = 0; // cell coordinate at the top left corner of the window
+        double cellSize = 1; // pixels per cell, below 1 several cells share a pixel
+
+        [[nodiscard]] int screenX(const double cellX) const noexcept {
+            return static_cast<int>(std::floor((cellX - originX) * cellSize));
+        }
+
+        [[nodiscard]] int screenY(const double cellY) const noexcept {
+            return static_cast<int>(std::floor((cellY - originY) * cellSize));
+        }
+
+        [[nodiscard]] double cellX(const double pixelX) const noexcept { return originX + pixelX / cellSize; }
+        [[nodiscard]] double cellY(const double pixelY) const noexcept { return originY + pixelY / cellSize; }
+
+        /// @return The cells intersecting the pixel rectangle.
+        [[nodiscard]] CellRect cellsIn(const int x, const int y, const int width, const int height) const noexcept {
+            const int firstX = static_cast<int>(std::floor(cellX(x)));
+            const int firstY = static_cast<int>(std::floor(cellY(y)));
+            const int lastX = static_cast<int>(std::ceil(cellX(x + width)));
+            const int lastY = static_cast<int>(std::ceil(cellY(y + height)));
+            return {firstX, firstY, lastX - firstX, lastY - firstY};
+        }
+
+        /// @return The cells intersecting the pixel rectangle, clipped to bounds.
+        [[nodiscard]] CellRect cellsIn(const int x, const int y, const int width, const int height,
+                                       const CellRect &bounds) const noexcept {
+            const CellRect cells = cellsIn(x, y, width, height);
+            const int firstX = std::max(cells.x, bounds.x), firstY = std::max(cells.y, bounds.y);
+            const int lastX = std::min(cells.x + cells.width, bounds.x + bounds.width);
+            const int lastY = std::min(cells.y + cells.height, bounds.y + bounds.height);
+            return {firstX, firstY, std::max(0, lastX - firstX), std::max(0, lastY - firstY)};
+        }
+
+        /// Show the area centred in a window of the given size.
+        void fit(const CellRect &area, const int windowWidth, const int windowHeight) noexcept {
+            cellSize = std::clamp(std::min(static_cast<double>(windowWidth) / area.width,
+                                           static_cast<double>(windowHeight) / area.height), minCellSize, maxCellSize);
+            originX = area.x + (area.width - windowWidth / cellSize) / 2;
+            originY = area.y + (area.height - windowHeight / cellSize) / 2;
+        }
+
+        /// Show the whole board centred in a window of the given size.
+        void fit(const int boardWidth, const int boardHeight, const int windowWidth, const int windowHeight) noexcept {
+            fit({0, 0, boardWidth, boardHeight}, windowWidth, windowHeight);
+        }
+
+        /// Scale by factor while keeping the cell under the given pixel in place.
+        void zoomAt(const int pixelX, const int pixelY, const double factor) noexcept {
+            const double anchorX = cellX(pixelX), anchorY = cellY(pixelY);
+            cellSize = std::clamp(cellSize * factor, minCellSize, maxCellSize);
+            originX = anchorX - pixelX / cellSize;
+            originY = anchorY - pixelY / cellSize;
+        }
+
+        /// Move the content by the given number of pixels.
+        void pan(const int dx, const int dy) noexcept {
+            originX -= dx / cellSize;
+            originY -= dy / cellSize;
+        }
+    };
+}
+
+#endif //X11TEST_VIEWPORT_H
@@ -1,13 +1,144 @@
+#include <algorithm>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
 
 #include "examples/GameOfLife.h"
+#include "examples/life/Checkpoint.h"
+#include "examples/life/PatternIO.h"
+#include "examples/life/ScalingReport.h"
 #include "../core/App.h"
-#include "helper/allocTracker.h"
 #include "helper/x11Detection.h"
 
 using X11App::App;
 
-int main() {
+struct Options {
+    GameOfLife::EngineConfig engine{};
+    unsigned threads = 0;
+    bool scalingReport = false;
+    std::string load{}, save{};
+    std::optional<GameOfLife::PatternStats> loadPeek{}; // of a pattern file to load, so it is not read twice
+    std::string checkpoint = "life.ckpt";
+    GameOfLife::CycleAction onCycle = GameOfLife::CycleAction::Report;
+    bool sizeGiven = false, ruleGiven = false;
+};
+
+/// Parse --engine=<bytes|bits|hashlife|rules>, --rule=<B3/S23 ...>, --kernel=<auto|scalar|avx2|avx512>,
+/// --width=<cells>, --height=<cells>, --hashlife-memory=<MiB>, --threads=<n>, --scaling-report,
+/// --load=<pattern or checkpoint>, --save=<pattern or .ckpt>, --checkpoint=<path> and
+/// --on-cycle=<ignore|report|pause>.
+/// @throws std::invalid_argument on unknown arguments or values.
+static Options parseOptions(const int argc, char **argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--engine=")) options.engine.engine = arg.substr(9);
+        else if (arg.starts_with("--rule=")) {
+            options.engine.rule = GameOfLife::LifeRule::parse(arg.substr(7));
+            options.ruleGiven = true;
+        }
+        else if (arg.starts_with("--kernel=")) options.engine.kernel = GameOfLife::kernelParse(arg.substr(9));
+        else if (arg.starts_with("--width=")) {
+            options.engine.width = std::stoi(std::string(arg.substr(8)));
+            options.sizeGiven = true;
+        } else if (arg.starts_with("--height=")) {
+            options.engine.height = std::stoi(std::string(arg.substr(9)));
+            options.sizeGiven = true;
+        }
+        else if (arg.starts_with("--hashlife-memory="))
+            options.engine.memoryLimitMb = std::stoul(std::string(arg.substr(18)));
+        else if (arg.starts_with("--threads=")) options.threads = std::stoul(std::string(arg.substr(10)));
+        else if (arg == "--scaling-report") options.scalingReport = true;
+        else if (arg.starts_with("--load=")) options.load = arg.substr(7);
+        else if (arg.starts_with("--save=")) options.save = arg.substr(7);
+        else if (arg.starts_with("--checkpoint=")) options.checkpoint = arg.substr(13);
+        else if (arg.starts_with("--on-cycle=")) options.onCycle = GameOfLife::cycleActionParse(arg.substr(11));
+        else throw std::invalid_argument("Unknown argument: " + std::string(arg));
+    }
+    if (!options.save.empty() && options.load.empty()) throw std::invalid_argument("--save needs --load");
+    return options;
+}
+
+/// Size the board to fit the pattern with room to grow and take over its rule, unless they were given.
+/// Checkpoints bring their own board size. Keeps the patternPeek of a pattern file for loading it.
+static void patternAdopt(Options &options) {
+    if (GameOfLife::checkpointIs(options.load)) {
+        const GameOfLife::Checkpoint checkpoint(options.load);
+        if (!options.sizeGiven) {
+            options.engine.width = checkpoint.width();
+            options.engine.height = checkpoint.height();
+        }
+        if (!options.ruleGiven) options.engine.rule = checkpoint.rule();
+        return;
+    }
+
+    const GameOfLife::PatternStats &pattern = options.loadPeek.emplace(GameOfLife::patternPeek(options.load));
+    if (!options.sizeGiven) {
+        options.engine.width = std::max(options.engine.width, pattern.width * 2);
+        options.engine.height = std::max(options.engine.height, pattern.height * 2);
+    }
+    if (!options.ruleGiven && !pattern.rule.empty()) options.engine.rule = GameOfLife::LifeRule::parse(pattern.rule);
+}
+
+/// Load the pattern or checkpoint and write it back out in the format of the save path, reporting the throughput
+/// of both.
+static void patternConvert(const Options &options) {
+    const auto engine = GameOfLife::engineCreate(options.engine);
+    std::cout << GameOfLife::boardLoad(*engine, options.load, options.loadPeek) << std::endl;
+    if (options.save.ends_with(".ckpt")) {
+        const auto stats = GameOfLife::checkpointWrite(*engine, options.save);
+        std::cout << "Saved checkpoint " << options.save << ": " << stats.toString() << std::endl;
+        return;
+    }
+    // all live cells, also those an unbounded engine has outside of its board
+    GameOfLife::BitBoard cells;
+    engine->snapshotArea(cells, engine->extent());
+    std::cout << "Saved " << options.save << ": "
+            << GameOfLife::patternSave(cells, options.save, GameOfLife::PatternFormat::Auto, engine->rule()).toString()
+            << std::endl;
+}
+
+int main(const int argc, char **argv) {
+#if TRACK_ALLOCATIONS
+    // cheap enough to leave on, the report shows where the allocations come from
+    X11App::allocSampleEvery(64);
+#endif
+    Options options;
+    try {
+        options = parseOptions(argc, argv);
+        if (!options.load.empty()) patternAdopt(options);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "Error: %s\n", e.what());
+        return -1;
+    }
+
+    // headless, so it also runs on build boxes without a display
+    if (options.scalingReport) {
+        try {
+            GameOfLife::scalingReport(std::cout, {
+                                          .maxThreads = options.threads, .kernel = options.engine.kernel,
+                                          .rule = options.engine.rule
+                                      });
+        } catch (const std::exception &e) {
+            // e.g. a rule the bit engine does not support
+            fprintf(stderr, "Error: %s\n", e.what());
+            return -1;
+        }
+        return 0;
+    }
+
+    // headless as well, for converting and benchmarking pattern files and checkpoints
+    if (!options.save.empty()) {
+        try {
+            patternConvert(options);
+        } catch (const std::exception &e) {
+            fprintf(stderr, "Error: %s\n", e.what());
+            return -1;
+        }
+        return 0;
+    }
+
     if (!isX11Installed()) {
         fprintf(stderr, "Error: Your system does not have X11 installed or running.\n");
         return -1;
@@ -20,14 +151,19 @@ int main() {
 #endif
 
     try {
-        const auto app = App::Create<GameOfLife::GameOfLifeApp>();
+        const auto app = App::Create<GameOfLife::GameOfLifeApp>(true, options.engine, options.threads,
+                                                                options.load, options.loadPeek,
+                                                                options.checkpoint, options.onCycle);
         app->run();
     } catch (const std::exception &e) {
         fprintf(stderr, "Error: %s\n", e.what());
     }
 
 #if TRACK_ALLOCATIONS
-    printAllocStats();
+    X11App::allocReport(std::cout);
+#endif
+#if PROFILING
+    X11App::Profiler::instance().report(std::cout);
 #endif
 
     return 0;